@@ -0,0 +1,301 @@
+#pragma once
+
+// bit_planes.hpp
+// 位平面：8 位图像与 8 张打包的二值平面（每个 uint64_t 存一行中连续 64 个像素，像素 x 在第 x/64 个字的第 x%64 位）
+//
+//   - 拆分：一遍扫描同时得到 8 个平面。AVX2 下 vpmovmskb 取出 32 个字节的最高位，
+//     字节自加（左移 1 位）后再取下一位，每 64 个像素 2 次加载 + 16 次 movemask，不生成 8 张 8 位中间图
+//   - 合并：逐平面把 32 位掩码广播、按字节展开（vpshufb + 比较），或上各自的位权，平面可在打包状态下修改后再合并
+//   - 二值形态学直接作用在打包平面上：水平方向是字内移位 + 相邻字的进位，竖直方向是整行按字与/或，
+//     一次处理 64 个像素
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * @struct BitPlane
+ * @brief  打包的二值图像：rows 行，每行 words 个 uint64_t，行尾多余的位恒为 0
+ */
+struct BitPlane
+{
+    int rows = 0, cols = 0, words = 0;
+    std::vector<uint64_t> data;
+
+    BitPlane() = default;
+    BitPlane(int r, int c) : rows(r), cols(c), words((c + 63) / 64), data(static_cast<size_t>(r) * words, 0) {}
+
+    uint64_t *row(int y) { return data.data() + static_cast<size_t>(y) * words; }
+    const uint64_t *row(int y) const { return data.data() + static_cast<size_t>(y) * words; }
+
+    // 最后一个字中有效位的掩码
+    uint64_t tailMask() const { return cols % 64 ? (uint64_t(1) << (cols % 64)) - 1 : ~uint64_t(0); }
+
+    // 值为 1 的像素数
+    int64_t count() const
+    {
+        int64_t n = 0;
+        for (uint64_t w : data)
+            n += std::popcount(w);
+        return n;
+    }
+};
+
+// 8 个位平面，下标即位号（0 为最低位）
+using BitPlanes = std::array<BitPlane, 8>;
+
+/*
+ * @function myBitPlaneSplit
+ * @brief  8 位单通道图像一遍拆成 8 个打包位平面
+ */
+inline BitPlanes myBitPlaneSplit(const cv::Mat &src)
+{
+    CV_Assert(src.type() == CV_8UC1);
+    BitPlanes planes;
+    for (auto &p : planes)
+        p = BitPlane(src.rows, src.cols);
+
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const uint8_t *s = src.ptr<uint8_t>(y);
+            uint64_t *dst[8];
+            for (int b = 0; b < 8; ++b)
+                dst[b] = planes[b].row(y);
+            int x = 0;
+#if defined(__AVX2__)
+            for (; x + 64 <= src.cols; x += 64)
+            {
+                __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + x));
+                __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + x + 32));
+                // movemask 取最高位；v + v 把下一位移到最高位
+                for (int b = 7; b >= 0; --b)
+                {
+                    const uint64_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(v0));
+                    const uint64_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(v1));
+                    dst[b][x / 64] = lo | (hi << 32);
+                    v0 = _mm256_add_epi8(v0, v0);
+                    v1 = _mm256_add_epi8(v1, v1);
+                }
+            }
+#endif
+            for (; x < src.cols; x += 64)
+            {
+                uint64_t w[8] = {};
+                const int n = std::min(64, src.cols - x);
+                for (int i = 0; i < n; ++i)
+                    for (int b = 0; b < 8; ++b)
+                        w[b] |= static_cast<uint64_t>((s[x + i] >> b) & 1) << i;
+                for (int b = 0; b < 8; ++b)
+                    dst[b][x / 64] = w[b];
+            }
+        } });
+    return planes;
+}
+
+#if defined(__AVX2__)
+// 32 位掩码展开为 32 个字节：第 i 位为 1 的字节为 0xFF
+inline __m256i bitExpand32(uint32_t m)
+{
+    const __m256i idx = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                         2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i sel = _mm256_set1_epi64x(static_cast<int64_t>(0x8040201008040201ULL));
+    const __m256i bytes = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(m)), idx);
+    return _mm256_cmpeq_epi8(_mm256_and_si256(bytes, sel), sel);
+}
+#endif
+
+/*
+ * @function bitPlaneExpandRow
+ * @brief  把一行的若干平面展开为字节：第 i 个平面的位为 1 时加上 weight[i]
+ */
+inline void bitPlaneExpandRow(const uint64_t *const *rows, const uint8_t *weight, int n, uint8_t *d, int cols)
+{
+    int x = 0;
+#if defined(__AVX2__)
+    for (; x + 64 <= cols; x += 64)
+    {
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0;
+        for (int i = 0; i < n; ++i)
+        {
+            const uint64_t w = rows[i][x / 64];
+            const __m256i wt = _mm256_set1_epi8(static_cast<char>(weight[i]));
+            acc0 = _mm256_or_si256(acc0, _mm256_and_si256(bitExpand32(static_cast<uint32_t>(w)), wt));
+            acc1 = _mm256_or_si256(acc1, _mm256_and_si256(bitExpand32(static_cast<uint32_t>(w >> 32)), wt));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + x), acc0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + x + 32), acc1);
+    }
+#endif
+    for (; x < cols; ++x)
+    {
+        uint8_t v = 0;
+        for (int i = 0; i < n; ++i)
+            if ((rows[i][x / 64] >> (x % 64)) & 1)
+                v |= weight[i];
+        d[x] = v;
+    }
+}
+
+/*
+ * @function myBitPlaneMerge
+ * @brief  8 个位平面合并回 8 位图像（平面 b 的位权为 1 << b）
+ */
+inline cv::Mat myBitPlaneMerge(const BitPlanes &planes)
+{
+    const int rows = planes[0].rows, cols = planes[0].cols;
+    for (const auto &p : planes)
+        CV_Assert(p.rows == rows && p.cols == cols);
+    cv::Mat dst(rows, cols, CV_8UC1);
+    const uint8_t weight[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const uint64_t *src[8];
+            for (int b = 0; b < 8; ++b)
+                src[b] = planes[b].row(y);
+            bitPlaneExpandRow(src, weight, 8, dst.ptr<uint8_t>(y), cols);
+        } });
+    return dst;
+}
+
+/*
+ * @function myBitPlaneToMat
+ * @brief  单个平面展开为 0/255 的 8 位图像（用于显示、保存）
+ */
+inline cv::Mat myBitPlaneToMat(const BitPlane &plane)
+{
+    cv::Mat dst(plane.rows, plane.cols, CV_8UC1);
+    const uint8_t weight = 255;
+    cv::parallel_for_(cv::Range(0, plane.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const uint64_t *src = plane.row(y);
+            bitPlaneExpandRow(&src, &weight, 1, dst.ptr<uint8_t>(y), plane.cols);
+        } });
+    return dst;
+}
+
+/*
+ * @function myBitPlaneFromMat
+ * @brief  8 位二值图像（非 0 即前景）打包为平面
+ */
+inline BitPlane myBitPlaneFromMat(const cv::Mat &src)
+{
+    CV_Assert(src.type() == CV_8UC1);
+    BitPlane plane(src.rows, src.cols);
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const uint8_t *s = src.ptr<uint8_t>(y);
+            uint64_t *d = plane.row(y);
+            int x = 0;
+#if defined(__AVX2__)
+            const __m256i zero = _mm256_setzero_si256();
+            for (; x + 64 <= src.cols; x += 64)
+            {
+                // 等于 0 的掩码取反
+                const uint64_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + x)), zero)));
+                const uint64_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + x + 32)), zero)));
+                d[x / 64] = ~(lo | (hi << 32));
+            }
+#endif
+            for (; x < src.cols; x += 64)
+            {
+                uint64_t w = 0;
+                const int n = std::min(64, src.cols - x);
+                for (int i = 0; i < n; ++i)
+                    w |= static_cast<uint64_t>(s[x + i] != 0) << i;
+                d[x / 64] = w;
+            }
+        } });
+    return plane;
+}
+
+/*
+ * @function bitMorphRow
+ * @brief  一行的水平方向腐蚀/膨胀：结果的像素 x 为 [x-r, x+r] 内像素的与/或
+ * @note   图像外的像素视为腐蚀的单位元 1、膨胀的单位元 0（与 cv::erode/dilate 的默认边界一致）
+ */
+template <bool kErode>
+inline void bitMorphRow(const uint64_t *s, uint64_t *d, int words, uint64_t tail, int r)
+{
+    const uint64_t pad = kErode ? ~uint64_t(0) : 0;
+    auto word = [&](int i) -> uint64_t
+    {
+        if (i < 0 || i >= words)
+            return pad;
+        // 腐蚀时行尾多余的位当作 1，不影响最后一个有效像素
+        return (kErode && i == words - 1) ? (s[i] | ~tail) : s[i];
+    };
+    for (int i = 0; i < words; ++i)
+    {
+        const uint64_t prev = word(i - 1), cur = word(i), next = word(i + 1);
+        uint64_t acc = cur;
+        for (int k = 1; k <= r; ++k)
+        {
+            // 像素 x 处放入 x-k 的值（左移）与 x+k 的值（右移），跨字的部分来自相邻字
+            const uint64_t left = (cur << k) | (prev >> (64 - k));
+            const uint64_t right = (cur >> k) | (next << (64 - k));
+            acc = kErode ? (acc & left & right) : (acc | left | right);
+        }
+        d[i] = acc;
+    }
+    d[words - 1] &= tail;
+}
+
+/*
+ * @function bitMorph
+ * @brief  矩形结构元 (2rx+1) x (2ry+1) 的腐蚀/膨胀：先水平后竖直（矩形结构元可分离）
+ */
+template <bool kErode>
+inline BitPlane bitMorph(const BitPlane &src, int rx, int ry)
+{
+    CV_Assert(rx >= 0 && rx < 64 && ry >= 0);
+    if (src.words == 0)
+        return src;
+    BitPlane tmp(src.rows, src.cols), dst(src.rows, src.cols);
+    const uint64_t tail = src.tailMask();
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+            bitMorphRow<kErode>(src.row(y), tmp.row(y), src.words, tail, rx); });
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+        {
+            uint64_t *d = dst.row(y);
+            std::copy(tmp.row(y), tmp.row(y) + src.words, d);
+            // 图像外的行是单位元，直接跳过
+            for (int yy = std::max(0, y - ry); yy <= std::min(src.rows - 1, y + ry); ++yy)
+            {
+                const uint64_t *t = tmp.row(yy);
+                for (int i = 0; i < src.words; ++i)
+                    d[i] = kErode ? (d[i] & t[i]) : (d[i] | t[i]);
+            }
+        } });
+    return dst;
+}
+
+/*
+ * @function myBinaryErode / myBinaryDilate / myBinaryOpen / myBinaryClose
+ * @brief  打包平面上的二值形态学（矩形结构元，半径 rx < 64、ry）
+ */
+inline BitPlane myBinaryErode(const BitPlane &src, int rx, int ry) { return bitMorph<true>(src, rx, ry); }
+inline BitPlane myBinaryDilate(const BitPlane &src, int rx, int ry) { return bitMorph<false>(src, rx, ry); }
+inline BitPlane myBinaryOpen(const BitPlane &src, int rx, int ry) { return myBinaryDilate(myBinaryErode(src, rx, ry), rx, ry); }
+inline BitPlane myBinaryClose(const BitPlane &src, int rx, int ry) { return myBinaryErode(myBinaryDilate(src, rx, ry), rx, ry); }
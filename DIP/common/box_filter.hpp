@@ -0,0 +1,164 @@
+#pragma once
+
+// box_filter.hpp
+// 与核大小无关的均值（box）滤波与积分图
+//
+// 均值滤波（边界为 BORDER_REFLECT，与 conv.hpp 一致）：
+//   - 竖直方向：每个行带维护各列的 kh 行列和，下移一行只加入新行、减去旧行
+//   - 水平方向：列和左右补镜像后做滑动和，右移一格只加一个、减一个
+//   - 每像素约 4 次加减，与核大小无关；整数输入用整数累加，输出 round(S / n)（就近取偶）。
+//     S / n 的正确舍入 double 在 .5 处恰好可表示，其余情况离 .5 至少 1/(2n)，所以结果是精确舍入；
+//     奇数尺寸的核（n 为奇数，没有 .5）与逐点 double 卷积的结果完全一致
+// 积分图：(rows+1) x (cols+1) 的前缀和（可选平方和），任意矩形的和为四次查表，供局部统计量等复用
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "conv.hpp"
+#include "pixel.hpp"
+
+/*
+ * @struct IntegralImage
+ * @brief  积分图：at(y, x) 为 [0, y) x [0, x) 内的和（整数输入用 int64_t，浮点输入用 double）
+ */
+template <typename T>
+struct IntegralImage
+{
+    int rows = 0, cols = 0; // 原图尺寸
+    std::vector<T> data;    // (rows+1) x (cols+1)
+
+    T at(int y, int x) const { return data[static_cast<size_t>(y) * (cols + 1) + x]; }
+
+    // 矩形 [x0, x1) x [y0, y1) 内的和
+    T sum(int x0, int y0, int x1, int y1) const { return at(y1, x1) - at(y0, x1) - at(y1, x0) + at(y0, x0); }
+    T sum(const cv::Rect &r) const { return sum(r.x, r.y, r.x + r.width, r.y + r.height); }
+};
+
+/*
+ * @function myIntegral
+ * @brief  单通道图像（CV_8U / CV_16U / CV_32F / CV_64F）的积分图
+ * @param  power 1 为像素和，2 为像素平方和（局部方差 = E[x^2] - E[x]^2）
+ */
+template <typename T>
+inline IntegralImage<T> myIntegral(const cv::Mat &src, int power = 1)
+{
+    CV_Assert(src.channels() == 1 && (power == 1 || power == 2));
+    CV_Assert(std::is_floating_point_v<T> || src.depth() == CV_8U || src.depth() == CV_16U);
+    IntegralImage<T> ii;
+    ii.rows = src.rows;
+    ii.cols = src.cols;
+    ii.data.assign(static_cast<size_t>(src.rows + 1) * (src.cols + 1), T(0));
+    myDispatchPixelType(src.type(), [&]<typename P, int CN>()
+                        {
+        for (int y = 0; y < src.rows; ++y)
+        {
+            const P *s = src.ptr<P>(y);
+            const T *up = &ii.data[static_cast<size_t>(y) * (src.cols + 1)];
+            T *cur = &ii.data[static_cast<size_t>(y + 1) * (src.cols + 1)];
+            T row = 0;
+            for (int x = 0; x < src.cols; ++x)
+            {
+                const T v = static_cast<T>(s[x]);
+                row += power == 1 ? v : v * v;
+                cur[x + 1] = up[x + 1] + row;
+            }
+        } });
+    return ii;
+}
+
+/*
+ * @function boxFilterRows
+ * @brief  均值滤波的一个行带 [y0, y1)：P 为像素类型，A 为累加类型
+ */
+template <typename P, typename A>
+inline void boxFilterRows(const cv::Mat &src, cv::Mat &dst, int kh, int kw, int y0, int y1,
+                          std::vector<A> &col, std::vector<A> &padded)
+{
+    const int ay = kh / 2, ax = kw / 2, cols = src.cols;
+    const double n = static_cast<double>(kh) * kw;
+
+    // 起始行的列和
+    std::fill(col.begin(), col.end(), A(0));
+    for (int i = 0; i < kh; ++i)
+    {
+        const P *s = src.ptr<P>(convReflect(y0 + i - ay, src.rows));
+        for (int x = 0; x < cols; ++x)
+            col[x] += s[x];
+    }
+
+    for (int y = y0; y < y1; ++y)
+    {
+        // 列和左右补镜像：镜像列的列和就是被镜像列的列和
+        for (int j = 0; j < ax; ++j)
+            padded[j] = col[convReflect(j - ax, cols)];
+        std::copy(col.begin(), col.end(), padded.begin() + ax);
+        for (int j = 0; j < kw - 1 - ax; ++j)
+            padded[ax + cols + j] = col[convReflect(cols + j, cols)];
+
+        // 水平滑动和
+        P *d = dst.ptr<P>(y);
+        A s = 0;
+        for (int j = 0; j < kw; ++j)
+            s += padded[j];
+        for (int x = 0; x < cols; ++x)
+        {
+            if constexpr (std::is_floating_point_v<P>)
+                d[x] = static_cast<P>(s / n);
+            else
+                d[x] = static_cast<P>(std::nearbyint(static_cast<double>(s) / n)); // 就近取偶，均值不会越界
+            if (x + 1 < cols)
+                s += padded[x + kw] - padded[x];
+        }
+
+        // 列和下移一行
+        if (y + 1 < y1)
+        {
+            const P *add = src.ptr<P>(convReflect(y + 1 + kh - 1 - ay, src.rows));
+            const P *sub = src.ptr<P>(convReflect(y - ay, src.rows));
+            for (int x = 0; x < cols; ++x)
+                col[x] += static_cast<A>(add[x]) - static_cast<A>(sub[x]);
+        }
+    }
+}
+
+/*
+ * @function myBoxFilter
+ * @brief  均值滤波（归一化的 box 滤波），每像素代价与核大小无关
+ * @param  src   CV_8UC1 / CV_16UC1 / CV_32FC1 / CV_64FC1
+ * @param  ksize 核尺寸（锚点在中心）
+ * @return       与 src 同类型
+ */
+inline cv::Mat myBoxFilter(const cv::Mat &src, cv::Size ksize)
+{
+    CV_Assert(src.type() == CV_8UC1 || src.type() == CV_16UC1 || src.type() == CV_32FC1 || src.type() == CV_64FC1);
+    CV_Assert(ksize.width > 0 && ksize.height > 0);
+    cv::Mat dst(src.size(), src.type());
+    const int kh = ksize.height, kw = ksize.width;
+    // 每个行带开头要重新求一次 kh 行的列和，行带取核高的数倍以摊薄这部分代价
+    const int band = std::max(32, 4 * kh);
+    const int bands = (src.rows + band - 1) / band;
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &r)
+                      {
+        myDispatchPixelType(src.type(), [&]<typename P, int CN>()
+                            {
+            // 窗口和：u8 在 kh*kw <= 2^23 时不会溢出 int32，u16 用 int64；浮点用 double 累加，避免滑动和的舍入误差积累
+            auto run = [&]<typename A>()
+            {
+                std::vector<A> col(src.cols), padded(src.cols + kw - 1);
+                for (int b = r.start; b < r.end; ++b)
+                    boxFilterRows<P, A>(src, dst, kh, kw, b * band, std::min(src.rows, (b + 1) * band), col, padded);
+            };
+            if constexpr (std::is_floating_point_v<P>)
+                run.template operator()<double>();
+            else if (sizeof(P) == 1 && static_cast<int64_t>(kh) * kw <= (1 << 23))
+                run.template operator()<int32_t>();
+            else
+                run.template operator()<int64_t>();
+        }); });
+    return dst;
+}
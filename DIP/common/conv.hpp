@@ -0,0 +1,605 @@
+#pragma once
+
+// conv.hpp
+// 8 位单通道图像的二维卷积（与 filter2D 相同，实际为相关：核不翻转，锚点在核中心；边界为 BORDER_REFLECT）
+//
+// 直接卷积引擎：
+//   - 按行带多线程。每个行带维护一个 kh 行的环形缓冲，源行只在进入缓冲时转成 float 一次，
+//     左右各补 kw/2 个镜像像素；边界只在这些行缓冲的两端和图像上下边缘的行映射中处理，不复制整幅图像
+//   - 内层为寄存器分块：AVX2 下 4 个 ymm 累加器（32 个输出像素）在全部 kh*kw 个抽头上常驻寄存器，
+//     每个抽头 4 次加载 + 4 次乘加，结果一次取整、饱和写回
+//   - 取整为就近取偶（与 saturate_cast<uchar>(double) 相同）
+//
+// 可分离 / 低秩核：
+//   - 核 K (kh x kw) 用单边 Jacobi SVD 分解为 sum_r s_r u_r v_r^T。秩 1 的核（高斯、均值）就是一次水平 + 一次竖直的
+//     一维卷积，秩 R 的核是 R 组这样的一维卷积之和，每像素代价 R*(kh+kw) 而不是 kh*kw
+//   - 截断到秩 R 的最大输出误差不超过 255 * sum|K - K_R|；取满足误差限的最小 R（tol = 0 时只允许浮点舍入级误差）
+//
+// FFT 卷积：
+//   - 实数到复数的 DFT（CCS 打包格式，只存一半频谱），与翻转后的核的频谱相乘后反变换
+//   - 在镜像补边后的虚拟图像上做重叠相加（overlap-add）：虚拟图像切成 B x B 的块，各块与核做线性卷积后
+//     累加到输出。块不大于 B 时整幅图一次完成；超大图像按块分，块的 DFT 尺寸固定，核频谱只算一次。
+//     相邻块的输出重叠 k-1，B >= k-1 时只有相邻块冲突，按 (行奇偶, 列奇偶) 分 4 轮，每轮内各块并行
+//   - 核频谱按 (核, DFT 尺寸) 缓存，同尺寸的多幅图像复用
+//
+// myConvolve 估计直接、低秩、FFT 三条路径的每像素代价（以乘加数计），选最便宜的一条：
+//   直接 kh*kw，低秩 R*(kh+kw+2)，FFT 约 6*log2(M*N) * (M*N)/(B*B)（正反两次变换 + 频谱相乘，按有效像素摊薄）
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * @function convReflect
+ * @brief  BORDER_REFLECT 的下标映射（fedcba|abcdefgh|hgfedcb）
+ */
+inline int convReflect(int p, int n)
+{
+    if (n == 1)
+        return 0;
+    while (p < 0 || p >= n)
+        p = p < 0 ? -p - 1 : 2 * n - p - 1;
+    return p;
+}
+
+/*
+ * @function convLoadRow
+ * @brief  源行转 float，左补 left、右补 right 个镜像像素：buf[left + x] = src[x]
+ */
+inline void convLoadRow(const uint8_t *src, int cols, int left, int right, float *buf)
+{
+    for (int x = 0; x < cols; ++x)
+        buf[left + x] = src[x];
+    for (int i = 1; i <= left; ++i)
+        buf[left - i] = src[convReflect(-i, cols)];
+    for (int i = 1; i <= right; ++i)
+        buf[left + cols - 1 + i] = src[convReflect(cols - 1 + i, cols)];
+}
+
+#if defined(__AVX2__)
+inline __m256 convMulAdd(__m256 a, __m256 b, __m256 c)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// 8 个 float 取整后饱和为 8 个字节
+inline void convStore8(uint8_t *d, __m256 v)
+{
+    __m256i i32 = _mm256_cvtps_epi32(v);
+    __m128i i16 = _mm_packs_epi32(_mm256_castsi256_si128(i32), _mm256_extracti128_si256(i32, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(d), _mm_packus_epi16(i16, i16));
+}
+#endif
+
+/*
+ * @function convRow
+ * @brief  由 kh 个已补边的 float 行算出一行 n 个输出：out[x] = sum_{i,j} k[i*kw+j] * rows[i][x+j]
+ */
+inline void convRow(const float *const *rows, const float *k, int kh, int kw, uint8_t *out, int n)
+{
+    int x = 0;
+#if defined(__AVX2__)
+    for (; x + 32 <= n; x += 32)
+    {
+        __m256 a0 = _mm256_setzero_ps(), a1 = a0, a2 = a0, a3 = a0;
+        for (int i = 0; i < kh; ++i)
+        {
+            const float *r = rows[i] + x;
+            const float *ki = k + i * kw;
+            for (int j = 0; j < kw; ++j)
+            {
+                const __m256 w = _mm256_set1_ps(ki[j]);
+                a0 = convMulAdd(_mm256_loadu_ps(r + j), w, a0);
+                a1 = convMulAdd(_mm256_loadu_ps(r + j + 8), w, a1);
+                a2 = convMulAdd(_mm256_loadu_ps(r + j + 16), w, a2);
+                a3 = convMulAdd(_mm256_loadu_ps(r + j + 24), w, a3);
+            }
+        }
+        convStore8(out + x, a0);
+        convStore8(out + x + 8, a1);
+        convStore8(out + x + 16, a2);
+        convStore8(out + x + 24, a3);
+    }
+    for (; x + 8 <= n; x += 8)
+    {
+        __m256 a = _mm256_setzero_ps();
+        for (int i = 0; i < kh; ++i)
+            for (int j = 0; j < kw; ++j)
+                a = convMulAdd(_mm256_loadu_ps(rows[i] + x + j), _mm256_set1_ps(k[i * kw + j]), a);
+        convStore8(out + x, a);
+    }
+#endif
+    for (; x < n; ++x)
+    {
+        float acc = 0;
+        for (int i = 0; i < kh; ++i)
+            for (int j = 0; j < kw; ++j)
+                acc += k[i * kw + j] * rows[i][x + j];
+        out[x] = cv::saturate_cast<uchar>(acc);
+    }
+}
+
+/*
+ * @function myConvDirect
+ * @brief  直接二维卷积
+ * @param  src    CV_8UC1
+ * @param  kernel 任意尺寸的单通道核（任意深度，内部转为 float）
+ * @return        CV_8UC1
+ */
+inline cv::Mat myConvDirect(const cv::Mat &src, const cv::Mat &kernel)
+{
+    CV_Assert(src.type() == CV_8UC1 && kernel.channels() == 1 && !kernel.empty());
+    cv::Mat kf;
+    kernel.convertTo(kf, CV_32F);
+    const int kh = kf.rows, kw = kf.cols;
+    const int ay = kh / 2, ax = kw / 2;
+    std::vector<float> k(static_cast<size_t>(kh) * kw);
+    for (int i = 0; i < kh; ++i)
+        for (int j = 0; j < kw; ++j)
+            k[static_cast<size_t>(i) * kw + j] = kf.ptr<float>(i)[j];
+
+    cv::Mat dst(src.size(), CV_8UC1);
+    const int width = src.cols + kw - 1; // 补边后的行长
+    constexpr int kBand = 32;
+    const int bands = (src.rows + kBand - 1) / kBand;
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &r)
+                      {
+        // 环形缓冲：第 v 个虚拟行（对应源行 v - ay 的镜像）放在槽 v % kh
+        std::vector<float> ring(static_cast<size_t>(kh) * width);
+        std::vector<int> held(kh, -1);
+        std::vector<const float *> rows(kh);
+        for (int b = r.start; b < r.end; ++b)
+        {
+            const int y0 = b * kBand, y1 = std::min(src.rows, y0 + kBand);
+            for (int y = y0; y < y1; ++y)
+            {
+                for (int i = 0; i < kh; ++i)
+                {
+                    const int v = y + i, slot = v % kh;
+                    float *buf = &ring[static_cast<size_t>(slot) * width];
+                    if (held[slot] != v)
+                    {
+                        convLoadRow(src.ptr<uint8_t>(convReflect(v - ay, src.rows)), src.cols, ax, kw - 1 - ax, buf);
+                        held[slot] = v;
+                    }
+                    rows[i] = buf;
+                }
+                convRow(rows.data(), k.data(), kh, kw, dst.ptr<uint8_t>(y), src.cols);
+            }
+        } });
+    return dst;
+}
+
+/*
+ * @function convRowF
+ * @brief  float 输出的一维/二维行卷积：out[x] (+)= sum_{i,j} k[i*kw+j] * rows[i][x+j]
+ * @note   水平一维卷积取 kh = 1，竖直一维卷积取 kw = 1；kAccumulate 为真时累加到 out 上
+ */
+template <bool kAccumulate>
+inline void convRowF(const float *const *rows, const float *k, int kh, int kw, float *out, int n)
+{
+    int x = 0;
+#if defined(__AVX2__)
+    for (; x + 32 <= n; x += 32)
+    {
+        __m256 a0 = _mm256_setzero_ps(), a1 = a0, a2 = a0, a3 = a0;
+        if (kAccumulate)
+        {
+            a0 = _mm256_loadu_ps(out + x);
+            a1 = _mm256_loadu_ps(out + x + 8);
+            a2 = _mm256_loadu_ps(out + x + 16);
+            a3 = _mm256_loadu_ps(out + x + 24);
+        }
+        for (int i = 0; i < kh; ++i)
+        {
+            const float *r = rows[i] + x;
+            const float *ki = k + i * kw;
+            for (int j = 0; j < kw; ++j)
+            {
+                const __m256 w = _mm256_set1_ps(ki[j]);
+                a0 = convMulAdd(_mm256_loadu_ps(r + j), w, a0);
+                a1 = convMulAdd(_mm256_loadu_ps(r + j + 8), w, a1);
+                a2 = convMulAdd(_mm256_loadu_ps(r + j + 16), w, a2);
+                a3 = convMulAdd(_mm256_loadu_ps(r + j + 24), w, a3);
+            }
+        }
+        _mm256_storeu_ps(out + x, a0);
+        _mm256_storeu_ps(out + x + 8, a1);
+        _mm256_storeu_ps(out + x + 16, a2);
+        _mm256_storeu_ps(out + x + 24, a3);
+    }
+#endif
+    for (; x < n; ++x)
+    {
+        float acc = kAccumulate ? out[x] : 0.0f;
+        for (int i = 0; i < kh; ++i)
+            for (int j = 0; j < kw; ++j)
+                acc += k[i * kw + j] * rows[i][x + j];
+        out[x] = acc;
+    }
+}
+
+// float 行取整、饱和为 8 位
+inline void convRoundRow(const float *src, uint8_t *dst, int n)
+{
+    int x = 0;
+#if defined(__AVX2__)
+    for (; x + 8 <= n; x += 8)
+        convStore8(dst + x, _mm256_loadu_ps(src + x));
+#endif
+    for (; x < n; ++x)
+        dst[x] = cv::saturate_cast<uchar>(src[x]);
+}
+
+/*
+ * @struct ConvKernelTerms
+ * @brief  核的低秩分解 K ~= sum_r col[r] * row[r]^T（col 长 kh，row 长 kw），error 为截断后的 255 * sum|K - K_R|
+ */
+struct ConvKernelTerms
+{
+    int kh = 0, kw = 0;
+    std::vector<std::vector<float>> col, row;
+    double error = 0;
+
+    int rank() const { return static_cast<int>(col.size()); }
+};
+
+/*
+ * @function convKernelSvd
+ * @brief  小矩阵的单边 Jacobi SVD：A (m x n, 行主序) = U diag(s) V^T，按奇异值降序返回
+ * @param  u 输出 n 个长度 m 的左奇异向量；v 输出 n 个长度 n 的右奇异向量
+ */
+inline void convKernelSvd(const std::vector<double> &A, int m, int n, std::vector<double> &s,
+                          std::vector<std::vector<double>> &u, std::vector<std::vector<double>> &v)
+{
+    // 按列存放，便于列旋转
+    std::vector<std::vector<double>> a(n, std::vector<double>(m)), vv(n, std::vector<double>(n, 0.0));
+    for (int j = 0; j < n; ++j)
+    {
+        for (int i = 0; i < m; ++i)
+            a[j][i] = A[static_cast<size_t>(i) * n + j];
+        vv[j][j] = 1.0;
+    }
+    // 范数相对整个矩阵可忽略的列（秩亏时旋转出的零列）不再参与旋转，否则舍入噪声会让迭代无法收敛
+    double frob2 = 0;
+    for (double x : A)
+        frob2 += x * x;
+    const double negligible = 1e-24 * frob2;
+    for (int sweep = 0; sweep < 60; ++sweep)
+    {
+        bool rotated = false;
+        for (int p = 0; p < n; ++p)
+            for (int q = p + 1; q < n; ++q)
+            {
+                double alpha = 0, beta = 0, gamma = 0;
+                for (int i = 0; i < m; ++i)
+                {
+                    alpha += a[p][i] * a[p][i];
+                    beta += a[q][i] * a[q][i];
+                    gamma += a[p][i] * a[q][i];
+                }
+                if (alpha <= negligible || beta <= negligible || std::abs(gamma) <= 1e-12 * std::sqrt(alpha * beta))
+                    continue;
+                rotated = true;
+                const double zeta = (beta - alpha) / (2 * gamma);
+                const double t = (zeta >= 0 ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                const double c = 1 / std::sqrt(1 + t * t), sn = c * t;
+                for (int i = 0; i < m; ++i)
+                {
+                    const double x = a[p][i], y = a[q][i];
+                    a[p][i] = c * x - sn * y;
+                    a[q][i] = sn * x + c * y;
+                }
+                for (int i = 0; i < n; ++i)
+                {
+                    const double x = vv[p][i], y = vv[q][i];
+                    vv[p][i] = c * x - sn * y;
+                    vv[q][i] = sn * x + c * y;
+                }
+            }
+        if (!rotated)
+            break;
+    }
+
+    std::vector<double> norm(n);
+    for (int j = 0; j < n; ++j)
+    {
+        double ss = 0;
+        for (double x : a[j])
+            ss += x * x;
+        norm[j] = std::sqrt(ss);
+    }
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int x, int y)
+              { return norm[x] > norm[y]; });
+    s.assign(n, 0);
+    u.assign(n, std::vector<double>(m, 0.0));
+    v.assign(n, {});
+    for (int r = 0; r < n; ++r)
+    {
+        const int j = order[r];
+        s[r] = norm[j];
+        if (norm[j] > 0)
+            for (int i = 0; i < m; ++i)
+                u[r][i] = a[j][i] / norm[j];
+        v[r] = vv[j];
+    }
+}
+
+/*
+ * @function myConvDecompose
+ * @brief  核的低秩分解
+ * @param  kernel 单通道核
+ * @param  tol    允许的最大输出误差（灰度级）；0 表示精确（只允许浮点舍入级误差）
+ */
+inline ConvKernelTerms myConvDecompose(const cv::Mat &kernel, double tol = 0)
+{
+    CV_Assert(kernel.channels() == 1 && !kernel.empty());
+    cv::Mat kd;
+    kernel.convertTo(kd, CV_64F);
+    ConvKernelTerms t;
+    t.kh = kd.rows;
+    t.kw = kd.cols;
+
+    // 较长的一边作为行数（Jacobi 旋转的是列），结果再转置回来
+    const bool transpose = t.kw > t.kh;
+    const int m = transpose ? t.kw : t.kh, n = transpose ? t.kh : t.kw;
+    std::vector<double> A(static_cast<size_t>(m) * n);
+    for (int i = 0; i < t.kh; ++i)
+        for (int j = 0; j < t.kw; ++j)
+            A[transpose ? static_cast<size_t>(j) * n + i : static_cast<size_t>(i) * n + j] = kd.ptr<double>(i)[j];
+    std::vector<double> s;
+    std::vector<std::vector<double>> u, v;
+    convKernelSvd(A, m, n, s, u, v);
+
+    // 逐个加入秩 1 项，直到残差满足误差限
+    const double limit = std::max(tol, 1e-3);
+    std::vector<double> residual = A;
+    for (int r = 0; r < n; ++r)
+    {
+        double err = 0;
+        for (double e : residual)
+            err += std::abs(e);
+        t.error = 255.0 * err;
+        if (t.error <= limit || s[r] == 0)
+            break;
+        for (int i = 0; i < m; ++i)
+            for (int j = 0; j < n; ++j)
+                residual[static_cast<size_t>(i) * n + j] -= s[r] * u[r][i] * v[r][j];
+        std::vector<float> c(m), w(n);
+        for (int i = 0; i < m; ++i)
+            c[i] = static_cast<float>(s[r] * u[r][i]);
+        for (int j = 0; j < n; ++j)
+            w[j] = static_cast<float>(v[r][j]);
+        t.col.push_back(transpose ? w : c);
+        t.row.push_back(transpose ? c : w);
+    }
+    if (t.rank() == n)
+        t.error = 0;
+    return t;
+}
+
+/*
+ * @function myConvSeparable
+ * @brief  低秩核的卷积：sum_r 竖直(col[r]) * 水平(row[r])
+ * @note   每个行带先把需要的源行转成补边的 float 行（各项共用），每一项做一遍水平卷积、再竖直累加到 float 结果上
+ */
+inline cv::Mat myConvSeparable(const cv::Mat &src, const ConvKernelTerms &terms)
+{
+    CV_Assert(src.type() == CV_8UC1 && terms.rank() > 0);
+    const int kh = terms.kh, kw = terms.kw;
+    const int ay = kh / 2, ax = kw / 2;
+    const int width = src.cols + kw - 1;
+    cv::Mat dst(src.size(), CV_8UC1);
+    constexpr int kBand = 32;
+    const int bands = (src.rows + kBand - 1) / kBand;
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &r)
+                      {
+        std::vector<float> padded(static_cast<size_t>(kBand + kh - 1) * width);
+        std::vector<float> horiz(static_cast<size_t>(kBand + kh - 1) * src.cols);
+        std::vector<float> acc(static_cast<size_t>(kBand) * src.cols);
+        std::vector<const float *> rows(kh);
+        for (int b = r.start; b < r.end; ++b)
+        {
+            const int y0 = b * kBand, y1 = std::min(src.rows, y0 + kBand);
+            const int n_in = y1 - y0 + kh - 1;
+            for (int i = 0; i < n_in; ++i)
+                convLoadRow(src.ptr<uint8_t>(convReflect(y0 + i - ay, src.rows)), src.cols, ax, kw - 1 - ax,
+                            &padded[static_cast<size_t>(i) * width]);
+
+            for (int t = 0; t < terms.rank(); ++t)
+            {
+                for (int i = 0; i < n_in; ++i)
+                {
+                    const float *p = &padded[static_cast<size_t>(i) * width];
+                    convRowF<false>(&p, terms.row[t].data(), 1, kw, &horiz[static_cast<size_t>(i) * src.cols], src.cols);
+                }
+                for (int y = y0; y < y1; ++y)
+                {
+                    for (int i = 0; i < kh; ++i)
+                        rows[i] = &horiz[static_cast<size_t>(y - y0 + i) * src.cols];
+                    float *out = &acc[static_cast<size_t>(y - y0) * src.cols];
+                    if (t == 0)
+                        convRowF<false>(rows.data(), terms.col[t].data(), kh, 1, out, src.cols);
+                    else
+                        convRowF<true>(rows.data(), terms.col[t].data(), kh, 1, out, src.cols);
+                }
+            }
+            for (int y = y0; y < y1; ++y)
+                convRoundRow(&acc[static_cast<size_t>(y - y0) * src.cols], dst.ptr<uint8_t>(y), src.cols);
+        } });
+    return dst;
+}
+
+// FFT 路径的块大小（虚拟补边图像中每块的边长上限）
+constexpr int kConvFftBlock = 1024;
+
+/*
+ * @struct ConvFftLayout
+ * @brief  FFT 路径的分块：虚拟图像每块 by x bx，块的 DFT 尺寸 M x N
+ */
+struct ConvFftLayout
+{
+    int by, bx, M, N;
+
+    ConvFftLayout(cv::Size img, int kh, int kw)
+    {
+        const int vh = img.height + kh - 1, vw = img.width + kw - 1; // 补边后的虚拟图像
+        // 块不小于 k-1，保证只有相邻块的输出重叠
+        by = vh <= kConvFftBlock ? vh : std::max(kConvFftBlock - (kh - 1), kh - 1);
+        bx = vw <= kConvFftBlock ? vw : std::max(kConvFftBlock - (kw - 1), kw - 1);
+        M = cv::getOptimalDFTSize(by + kh - 1);
+        N = cv::getOptimalDFTSize(bx + kw - 1);
+    }
+
+    // 每个输出像素分摊的乘加数
+    double cost() const
+    {
+        const double mn = static_cast<double>(M) * N;
+        return 6.0 * std::log2(mn) * mn / (static_cast<double>(by) * bx);
+    }
+};
+
+/*
+ * @function convFftKernelSpectrum
+ * @brief  翻转后的核放在 M x N 零矩阵左上角的 DFT（CCS 格式）；按 (核, M, N) 缓存最近用过的 8 个
+ */
+inline cv::Mat convFftKernelSpectrum(const cv::Mat &kf, int M, int N)
+{
+    struct Entry
+    {
+        int kh, kw, M, N;
+        std::vector<float> taps;
+        cv::Mat spectrum;
+    };
+    static std::mutex mutex;
+    static std::list<Entry> cache;
+
+    std::vector<float> taps(static_cast<size_t>(kf.rows) * kf.cols);
+    for (int i = 0; i < kf.rows; ++i)
+        std::memcpy(&taps[static_cast<size_t>(i) * kf.cols], kf.ptr<float>(i), kf.cols * sizeof(float));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = cache.begin(); it != cache.end(); ++it)
+        if (it->kh == kf.rows && it->kw == kf.cols && it->M == M && it->N == N && it->taps == taps)
+        {
+            cache.splice(cache.begin(), cache, it);
+            return it->spectrum;
+        }
+
+    cv::Mat padded = cv::Mat::zeros(M, N, CV_32F);
+    for (int i = 0; i < kf.rows; ++i)
+        for (int j = 0; j < kf.cols; ++j)
+            padded.ptr<float>(kf.rows - 1 - i)[kf.cols - 1 - j] = kf.ptr<float>(i)[j];
+    cv::Mat spectrum;
+    cv::dft(padded, spectrum, 0, kf.rows);
+    cache.push_front({kf.rows, kf.cols, M, N, std::move(taps), spectrum});
+    if (cache.size() > 8)
+        cache.pop_back();
+    return spectrum;
+}
+
+/*
+ * @function myConvFFT
+ * @brief  FFT 卷积（重叠相加），语义与 myConvDirect 相同
+ */
+inline cv::Mat myConvFFT(const cv::Mat &src, const cv::Mat &kernel)
+{
+    CV_Assert(src.type() == CV_8UC1 && kernel.channels() == 1 && !kernel.empty());
+    cv::Mat kf;
+    kernel.convertTo(kf, CV_32F);
+    const int kh = kf.rows, kw = kf.cols, ay = kh / 2, ax = kw / 2;
+    const ConvFftLayout lay(src.size(), kh, kw);
+    const cv::Mat kspec = convFftKernelSpectrum(kf, lay.M, lay.N);
+
+    // 虚拟图像 V[v][u] = src[reflect(v - ay)][reflect(u - ax)]；线性卷积 F = V * flip(K)，输出为 F[y+kh-1][x+kw-1]
+    const int vh = src.rows + kh - 1, vw = src.cols + kw - 1;
+    const int nby = (vh + lay.by - 1) / lay.by, nbx = (vw + lay.bx - 1) / lay.bx;
+    cv::Mat acc = cv::Mat::zeros(src.size(), CV_32F);
+    std::vector<int> col_map(vw);
+    for (int u = 0; u < vw; ++u)
+        col_map[u] = convReflect(u - ax, src.cols);
+
+    for (int phase = 0; phase < 4; ++phase)
+    {
+        std::vector<cv::Point> blocks;
+        for (int i = phase / 2; i < nby; i += 2)
+            for (int j = phase % 2; j < nbx; j += 2)
+                blocks.emplace_back(j, i);
+        cv::parallel_for_(cv::Range(0, static_cast<int>(blocks.size())), [&](const cv::Range &r)
+                          {
+            for (int b = r.start; b < r.end; ++b)
+            {
+                const int v0 = blocks[b].y * lay.by, u0 = blocks[b].x * lay.bx;
+                const int bh = std::min(lay.by, vh - v0), bw = std::min(lay.bx, vw - u0);
+                cv::Mat block = cv::Mat::zeros(lay.M, lay.N, CV_32F);
+                for (int i = 0; i < bh; ++i)
+                {
+                    const uint8_t *s = src.ptr<uint8_t>(convReflect(v0 + i - ay, src.rows));
+                    float *d = block.ptr<float>(i);
+                    for (int j = 0; j < bw; ++j)
+                        d[j] = s[col_map[u0 + j]];
+                }
+                cv::Mat spec, conv;
+                cv::dft(block, spec, 0, bh);
+                cv::mulSpectrums(spec, kspec, spec, 0);
+                cv::dft(spec, conv, cv::DFT_INVERSE | cv::DFT_REAL_OUTPUT | cv::DFT_SCALE, bh + kh - 1);
+
+                // 块的线性卷积覆盖 F 的 [v0, v0+bh+kh-1) x [u0, u0+bw+kw-1)，只累加落在输出范围内的部分
+                const int y_lo = std::max(0, v0 - (kh - 1)), y_hi = std::min(src.rows, v0 + bh);
+                const int x_lo = std::max(0, u0 - (kw - 1)), x_hi = std::min(src.cols, u0 + bw);
+                for (int y = y_lo; y < y_hi; ++y)
+                {
+                    const float *c = conv.ptr<float>(y + kh - 1 - v0) + (kw - 1 - u0);
+                    float *a = acc.ptr<float>(y);
+                    for (int x = x_lo; x < x_hi; ++x)
+                        a[x] += c[x];
+                }
+            } });
+    }
+
+    cv::Mat dst(src.size(), CV_8UC1);
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+            convRoundRow(acc.ptr<float>(y), dst.ptr<uint8_t>(y), src.cols); });
+    return dst;
+}
+
+/*
+ * @function myConvolve
+ * @brief  二维卷积前端：按每像素代价在直接卷积、低秩分解与 FFT 之间自动选择
+ * @param  src    CV_8UC1
+ * @param  kernel 任意单通道核
+ * @param  tol    低秩近似允许的最大输出误差（灰度级），0 表示只用精确分解
+ * @return        CV_8UC1
+ */
+inline cv::Mat myConvolve(const cv::Mat &src, const cv::Mat &kernel, double tol = 0)
+{
+    const ConvKernelTerms terms = myConvDecompose(kernel, tol);
+    const double direct_cost = static_cast<double>(terms.kh) * terms.kw;
+    // 低秩路径每一项：水平 kw + 竖直 kh 次乘加，另加中间结果的读写
+    const double separable_cost = terms.rank() > 0 ? terms.rank() * (terms.kh + terms.kw + 2.0) : direct_cost;
+    const double fft_cost = ConvFftLayout(src.size(), terms.kh, terms.kw).cost();
+    if (fft_cost < std::min(direct_cost, separable_cost))
+        return myConvFFT(src, kernel);
+    if (separable_cost < direct_cost)
+        return myConvSeparable(src, terms);
+    return myConvDirect(src, kernel);
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+// feature_store.hpp
+// 参考图像的 ORB 关键点 / 描述子持久化存储
+//
+// 同一张参考图像会被成千上万张图像配准，参考图的检测结果只算一次：
+//   - 键：图像内容（尺寸、类型、像素）的 FNV-1a 哈希 + 检测器参数，同时用作文件名
+//   - 文件：固定头 + 关键点数组 + 描述子数组（64 字节对齐），直接 mmap 到内存
+//   - 描述子以 cv::Mat 头的形式指向映射区域，匹配器零拷贝读取
+// 写文件时先写临时文件再 rename，多个进程同时填充同一个键也不会读到半个文件。
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/features2d.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * @struct OrbParams
+ * @brief  参与缓存键的 ORB 参数（其余参数取 OpenCV 默认值）
+ */
+struct OrbParams
+{
+    int nfeatures = 1000;
+    float scale_factor = 1.2f;
+    int nlevels = 8;
+    int edge_threshold = 31;
+    int fast_threshold = 20;
+
+    cv::Ptr<cv::ORB> create() const
+    {
+        return cv::ORB::create(nfeatures, scale_factor, nlevels, edge_threshold, 0, 2, cv::ORB::HARRIS_SCORE,
+                               31, fast_threshold);
+    }
+};
+
+// FNV-1a 增量哈希
+inline uint64_t featureHashBytes(uint64_t h, const void *data, size_t n)
+{
+    const uchar *p = static_cast<const uchar *>(data);
+    for (size_t i = 0; i < n; ++i)
+    {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/*
+ * @function myFeatureStoreKey
+ * @brief  图像内容 + 检测器参数的哈希
+ */
+inline uint64_t myFeatureStoreKey(const cv::Mat &img, const OrbParams &params)
+{
+    uint64_t h = 1469598103934665603ull;
+    const int header[3] = {img.rows, img.cols, img.type()};
+    h = featureHashBytes(h, header, sizeof(header));
+    const size_t row_bytes = img.cols * img.elemSize();
+    for (int y = 0; y < img.rows; ++y)
+        h = featureHashBytes(h, img.ptr<uchar>(y), row_bytes);
+    h = featureHashBytes(h, &params.nfeatures, sizeof(int));
+    h = featureHashBytes(h, &params.scale_factor, sizeof(float));
+    h = featureHashBytes(h, &params.nlevels, sizeof(int));
+    h = featureHashBytes(h, &params.edge_threshold, sizeof(int));
+    h = featureHashBytes(h, &params.fast_threshold, sizeof(int));
+    return h;
+}
+
+/*
+ * @struct FeatureFileHeader
+ * @brief  存储文件头；关键点从 keypoint_offset 开始，描述子从 descriptor_offset 开始
+ */
+struct FeatureFileHeader
+{
+    char magic[4];
+    int32_t version;
+    uint64_t key;
+    int32_t count;
+    int32_t descriptor_bytes;
+    uint64_t keypoint_offset;
+    uint64_t descriptor_offset;
+};
+
+// 文件中的关键点记录（与 cv::KeyPoint 的字段一一对应，布局固定）
+struct FeatureFileKeyPoint
+{
+    float x, y, size, angle, response;
+    int32_t octave, class_id;
+};
+
+/*
+ * @class MappedFeatures
+ * @brief  一个映射到内存的存储文件；析构时解除映射
+ */
+class MappedFeatures
+{
+public:
+    MappedFeatures() = default;
+    MappedFeatures(const MappedFeatures &) = delete;
+    MappedFeatures &operator=(const MappedFeatures &) = delete;
+    ~MappedFeatures()
+    {
+        if (base_)
+            munmap(base_, size_);
+    }
+
+    /*
+     * @function open
+     * @brief  映射文件并校验文件头
+     * @param  key 期望的键（哈希碰撞或文件损坏时返回 false）
+     */
+    bool open(const std::string &path, uint64_t key)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FeatureFileHeader)))
+        {
+            ::close(fd);
+            return false;
+        }
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return false;
+        base_ = p;
+        size_ = st.st_size;
+
+        const FeatureFileHeader &h = header();
+        const uint64_t kp_end = h.keypoint_offset + static_cast<uint64_t>(h.count) * sizeof(FeatureFileKeyPoint);
+        const uint64_t desc_end = h.descriptor_offset + static_cast<uint64_t>(h.count) * h.descriptor_bytes;
+        if (std::memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || h.key != key || h.count < 0 ||
+            kp_end > size_ || desc_end > size_)
+        {
+            munmap(base_, size_);
+            base_ = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    int count() const { return header().count; }
+
+    // 描述子：指向映射区域的 cv::Mat 头，不拷贝
+    cv::Mat descriptors() const
+    {
+        const FeatureFileHeader &h = header();
+        uchar *p = static_cast<uchar *>(base_) + h.descriptor_offset;
+        return cv::Mat(h.count, h.descriptor_bytes, CV_8U, p);
+    }
+
+    // 关键点需要 cv::KeyPoint 时才展开（绘图、构造点对）
+    std::vector<cv::KeyPoint> keypoints() const
+    {
+        const FeatureFileHeader &h = header();
+        const FeatureFileKeyPoint *kp = reinterpret_cast<const FeatureFileKeyPoint *>(
+            static_cast<const uchar *>(base_) + h.keypoint_offset);
+        std::vector<cv::KeyPoint> out;
+        out.reserve(h.count);
+        for (int i = 0; i < h.count; ++i)
+            out.emplace_back(cv::Point2f(kp[i].x, kp[i].y), kp[i].size, kp[i].angle, kp[i].response, kp[i].octave,
+                             kp[i].class_id);
+        return out;
+    }
+
+    /*
+     * @function write
+     * @brief  写出存储文件（先写临时文件再 rename）
+     */
+    static bool write(const std::string &path, uint64_t key, const std::vector<cv::KeyPoint> &kps,
+                      const cv::Mat &desc)
+    {
+        CV_Assert(desc.empty() || (desc.type() == CV_8U && desc.rows == static_cast<int>(kps.size())));
+        FeatureFileHeader h{};
+        std::memcpy(h.magic, kMagic, 4);
+        h.version = kVersion;
+        h.key = key;
+        h.count = static_cast<int32_t>(kps.size());
+        h.descriptor_bytes = desc.empty() ? 32 : desc.cols;
+        h.keypoint_offset = sizeof(FeatureFileHeader);
+        h.descriptor_offset = align64(h.keypoint_offset + kps.size() * sizeof(FeatureFileKeyPoint));
+
+        const std::string tmp = path + ".tmp" + std::to_string(::getpid());
+        {
+            std::ofstream ofs(tmp, std::ios::binary);
+            if (!ofs)
+                return false;
+            ofs.write(reinterpret_cast<const char *>(&h), sizeof(h));
+            for (const auto &k : kps)
+            {
+                FeatureFileKeyPoint r{k.pt.x, k.pt.y, k.size, k.angle, k.response, k.octave, k.class_id};
+                ofs.write(reinterpret_cast<const char *>(&r), sizeof(r));
+            }
+            const uint64_t pad = h.descriptor_offset - (h.keypoint_offset + kps.size() * sizeof(FeatureFileKeyPoint));
+            const char zeros[64] = {};
+            ofs.write(zeros, static_cast<std::streamsize>(pad));
+            for (int r = 0; r < desc.rows; ++r)
+                ofs.write(reinterpret_cast<const char *>(desc.ptr<uchar>(r)), desc.cols);
+            if (!ofs)
+                return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        return !ec;
+    }
+
+private:
+    static constexpr char kMagic[4] = {'F', 'S', 'T', 'R'};
+    static constexpr int kVersion = 1;
+
+    void *base_ = nullptr;
+    size_t size_ = 0;
+
+    const FeatureFileHeader &header() const { return *static_cast<const FeatureFileHeader *>(base_); }
+    static uint64_t align64(uint64_t v) { return (v + 63) & ~uint64_t(63); }
+};
+
+/*
+ * @class FeatureStore
+ * @brief  参考特征缓存：进程内按键复用映射，磁盘上每个键一个 feat_<hash>.orb 文件
+ */
+class FeatureStore
+{
+public:
+    explicit FeatureStore(std::string dir, OrbParams params = OrbParams()) : dir_(std::move(dir)), params_(params)
+    {
+        std::filesystem::create_directories(dir_);
+    }
+
+    /*
+     * @function get
+     * @brief  取参考图像的特征：命中时直接映射文件，未命中时检测一次并写入存储
+     * @param  img 参考图像
+     * @return     映射后的特征；写入或映射失败时返回 nullptr
+     */
+    std::shared_ptr<const MappedFeatures> get(const cv::Mat &img)
+    {
+        const uint64_t key = myFeatureStoreKey(img, params_);
+        auto it = mapped_.find(key);
+        if (it != mapped_.end())
+            return it->second;
+
+        const std::string path = pathFor(key);
+        auto mf = std::make_shared<MappedFeatures>();
+        if (!mf->open(path, key))
+        {
+            std::vector<cv::KeyPoint> kps;
+            cv::Mat desc;
+            params_.create()->detectAndCompute(img, cv::noArray(), kps, desc);
+            if (!MappedFeatures::write(path, key, kps, desc) || !mf->open(path, key))
+            {
+                std::cerr << "无法写入特征存储：" << path << std::endl;
+                return nullptr;
+            }
+            hits_ = false;
+        }
+        else
+        {
+            hits_ = true;
+        }
+        mapped_.emplace(key, mf);
+        return mf;
+    }
+
+    const OrbParams &params() const { return params_; }
+    // 最近一次 get() 是否命中磁盘上已有的文件
+    bool lastWasHit() const { return hits_; }
+
+private:
+    std::string dir_;
+    OrbParams params_;
+    bool hits_ = false;
+    std::unordered_map<uint64_t, std::shared_ptr<const MappedFeatures>> mapped_;
+
+    std::string pathFor(uint64_t key) const
+    {
+        std::ostringstream name;
+        name << "feat_" << std::hex << std::setw(16) << std::setfill('0') << key << ".orb";
+        return (std::filesystem::path(dir_) / name.str()).string();
+    }
+};
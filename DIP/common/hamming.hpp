@@ -0,0 +1,368 @@
+#pragma once
+
+// hamming.hpp
+// ORB 等二进制描述子的匹配：分块暴力 2-NN + 比率测试，以及多探针 LSH 索引（面向大量参考图像）
+//
+// 暴力匹配：
+//   - 256 位描述子的距离用 POPCNT（std::popcount 在 -march=native 下编译为 popcnt 指令）；
+//     AVX2 下一次算 1 个查询对 4 个训练描述子：vpshufb 半字节查表 + vpsadbw 求和
+//   - 查询 x 训练按块遍历：一块训练描述子（32 KB）留在 L1 中，被一块查询反复使用
+//   - 每个查询只保留最近与次近两个距离，遍历结束即做比率测试，不生成 knn 中间结果
+//   - 查询块之间用 cv::parallel_for_ 多线程
+// LSH：每张表取描述子中固定的 K 个随机位作为桶号，查询时探测本桶以及桶号翻转 1 位的 K 个邻桶，
+//      候选去重后再算精确距离，对大量参考描述子是亚线性的。
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/features2d.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// 分块大小：一块训练描述子 1024 x 32 B = 32 KB，一块查询 64 个
+constexpr int kHammingTrainBlock = 1024;
+constexpr int kHammingQueryBlock = 64;
+
+/*
+ * @function myHammingDistance
+ * @brief  两个二进制描述子的汉明距离
+ * @param  a, b  描述子首地址
+ * @param  bytes 描述子字节数（ORB 为 32）
+ */
+inline int myHammingDistance(const uchar *a, const uchar *b, int bytes)
+{
+    int d = 0;
+    int i = 0;
+    for (; i + 8 <= bytes; i += 8)
+    {
+        uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        d += std::popcount(x ^ y);
+    }
+    for (; i < bytes; ++i)
+        d += std::popcount(static_cast<unsigned>(a[i] ^ b[i]));
+    return d;
+}
+
+#if defined(__AVX2__)
+// 32 字节中每个字节的 1 的个数（半字节查表）
+inline __m256i hammingPopcnt8(__m256i v)
+{
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    return _mm256_add_epi8(lo, hi);
+}
+
+/*
+ * @function hammingDistance256x4
+ * @brief  1 个 256 位查询对 4 个连续存放的 256 位训练描述子的距离
+ * @note   vpsadbw 把每 8 字节的计数加成一个 64 位数；4 个训练描述子的结果分别左移 0/16/32/48 位后相加，
+ *         最后把 4 个 64 位通道相加，每个 16 位字段就是一个距离（最大 256）
+ */
+inline void hammingDistance256x4(const uchar *q, const uchar *t, int *out)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qv = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(q));
+    __m256i acc = zero;
+    for (int j = 0; j < 4; ++j)
+    {
+        __m256i tv = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t + 32 * j));
+        __m256i s = _mm256_sad_epu8(hammingPopcnt8(_mm256_xor_si256(qv, tv)), zero);
+        acc = _mm256_add_epi64(acc, _mm256_slli_epi64(s, 16 * j));
+    }
+    __m128i s2 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    uint64_t packed = static_cast<uint64_t>(_mm_cvtsi128_si64(s2)) + static_cast<uint64_t>(_mm_extract_epi64(s2, 1));
+    for (int j = 0; j < 4; ++j)
+        out[j] = static_cast<int>((packed >> (16 * j)) & 0xFFFF);
+}
+#endif
+
+/*
+ * @struct HammingBest2
+ * @brief  一个查询当前的最近、次近训练描述子
+ */
+struct HammingBest2
+{
+    int idx1 = -1, d1 = INT32_MAX;
+    int idx2 = -1, d2 = INT32_MAX;
+
+    // 距离相同时保留下标较小者（与 BFMatcher 的遍历顺序一致）
+    void push(int idx, int d)
+    {
+        if (d < d1)
+        {
+            idx2 = idx1;
+            d2 = d1;
+            idx1 = idx;
+            d1 = d;
+        }
+        else if (d < d2)
+        {
+            idx2 = idx;
+            d2 = d;
+        }
+    }
+};
+
+/*
+ * @function myHammingRatioMatch
+ * @brief  分块暴力 2-NN 匹配 + 比率测试（等价于 BFMatcher(NORM_HAMMING).knnMatch(k=2) 后做比率测试）
+ * @param  query  查询描述子（CV_8U，每行一个）
+ * @param  train  训练描述子（CV_8U，列数与 query 相同）
+ * @param  ratio  比率阈值：d1 < ratio * d2 时保留
+ * @param  ratios 可选输出，与返回值一一对应的 d1 / d2（越小越可靠，可用于 PROSAC 排序）
+ * @return        通过比率测试的匹配，按查询下标升序
+ */
+inline std::vector<cv::DMatch> myHammingRatioMatch(const cv::Mat &query, const cv::Mat &train, float ratio,
+                                                   std::vector<float> *ratios = nullptr)
+{
+    std::vector<cv::DMatch> good;
+    if (ratios)
+        ratios->clear();
+    if (query.empty() || train.rows < 2)
+        return good;
+    CV_Assert(query.type() == CV_8U && train.type() == CV_8U && query.cols == train.cols);
+
+    const int bytes = query.cols;
+    // 训练描述子连续存放，AVX2 路径按 4 个一组读取
+    const cv::Mat tr = train.isContinuous() ? train : train.clone();
+    const uchar *tbase = tr.ptr<uchar>(0);
+
+    std::vector<HammingBest2> best(query.rows);
+    const int qblocks = (query.rows + kHammingQueryBlock - 1) / kHammingQueryBlock;
+
+    cv::parallel_for_(cv::Range(0, qblocks), [&](const cv::Range &range)
+                      {
+        for (int qb = range.start; qb < range.end; ++qb)
+        {
+            const int q0 = qb * kHammingQueryBlock, q1 = std::min(q0 + kHammingQueryBlock, query.rows);
+            for (int t0 = 0; t0 < tr.rows; t0 += kHammingTrainBlock)
+            {
+                const int t1 = std::min(t0 + kHammingTrainBlock, tr.rows);
+                for (int q = q0; q < q1; ++q)
+                {
+                    const uchar *qd = query.ptr<uchar>(q);
+                    HammingBest2 &b = best[q];
+                    int t = t0;
+#if defined(__AVX2__)
+                    if (bytes == 32)
+                    {
+                        int d[4];
+                        for (; t + 4 <= t1; t += 4)
+                        {
+                            hammingDistance256x4(qd, tbase + static_cast<size_t>(t) * 32, d);
+                            for (int j = 0; j < 4; ++j)
+                                b.push(t + j, d[j]);
+                        }
+                    }
+#endif
+                    for (; t < t1; ++t)
+                        b.push(t, myHammingDistance(qd, tbase + static_cast<size_t>(t) * bytes, bytes));
+                }
+            }
+        } });
+
+    for (int q = 0; q < query.rows; ++q)
+    {
+        const HammingBest2 &b = best[q];
+        if (b.idx2 < 0)
+            continue;
+        if (b.d1 < ratio * b.d2)
+        {
+            good.emplace_back(q, b.idx1, static_cast<float>(b.d1));
+            if (ratios)
+                ratios->push_back(b.d2 > 0 ? static_cast<float>(b.d1) / b.d2 : 0.0f);
+        }
+    }
+    return good;
+}
+
+/*
+ * @class HammingLshIndex
+ * @brief  多探针 LSH 索引，可以容纳多张参考图像的描述子
+ * @note   用法：add() 逐张加入参考描述子 -> build() -> match()；
+ *         每张表是 CSR 结构（桶偏移 + 行号），查询时不分配内存以外的额外结构
+ */
+class HammingLshIndex
+{
+public:
+    /*
+     * @param tables   哈希表个数
+     * @param key_bits 每张表的桶号位数（桶数为 2^key_bits）
+     * @param seed     选取采样位的随机种子
+     */
+    explicit HammingLshIndex(int tables = 6, int key_bits = 14, uint32_t seed = 0x5EED)
+        : tables_(tables), key_bits_(key_bits), seed_(seed)
+    {
+        CV_Assert(tables > 0 && key_bits > 0 && key_bits <= 24);
+    }
+
+    /*
+     * @function add
+     * @brief  加入一张参考图像的描述子
+     * @return 该图像的编号（即 match() 结果中的 imgIdx）
+     */
+    int add(const cv::Mat &descriptors)
+    {
+        CV_Assert(descriptors.type() == CV_8U);
+        if (bytes_ == 0)
+            bytes_ = descriptors.cols;
+        CV_Assert(descriptors.cols == bytes_);
+        const int image = static_cast<int>(image_start_.size());
+        image_start_.push_back(rows_);
+        for (int r = 0; r < descriptors.rows; ++r)
+        {
+            const uchar *p = descriptors.ptr<uchar>(r);
+            data_.insert(data_.end(), p, p + bytes_);
+            row_image_.push_back(image);
+        }
+        rows_ += descriptors.rows;
+        built_ = false;
+        return image;
+    }
+
+    /*
+     * @function build
+     * @brief  选取采样位并建立各表的桶
+     */
+    void build()
+    {
+        CV_Assert(bytes_ > 0);
+        const int nbits = bytes_ * 8;
+        const int nbuckets = 1 << key_bits_;
+        std::mt19937 rng(seed_);
+        std::uniform_int_distribution<int> pick(0, nbits - 1);
+
+        bits_.assign(static_cast<size_t>(tables_) * key_bits_, 0);
+        offsets_.assign(static_cast<size_t>(tables_) * (nbuckets + 1), 0);
+        ids_.assign(static_cast<size_t>(tables_) * rows_, 0);
+
+        std::vector<uint32_t> keys(rows_);
+        for (int t = 0; t < tables_; ++t)
+        {
+            for (int k = 0; k < key_bits_; ++k)
+                bits_[t * key_bits_ + k] = pick(rng);
+
+            int *off = offsets_.data() + static_cast<size_t>(t) * (nbuckets + 1);
+            for (int r = 0; r < rows_; ++r)
+            {
+                keys[r] = key(t, row(r));
+                ++off[keys[r] + 1];
+            }
+            for (int b = 0; b < nbuckets; ++b)
+                off[b + 1] += off[b];
+
+            std::vector<int> fill(off, off + nbuckets);
+            int *ids = ids_.data() + static_cast<size_t>(t) * rows_;
+            for (int r = 0; r < rows_; ++r)
+                ids[fill[keys[r]]++] = r;
+        }
+        built_ = true;
+    }
+
+    /*
+     * @function match
+     * @brief  对每个查询在索引中找 2-NN 并做比率测试
+     * @param  query  查询描述子
+     * @param  ratio  比率阈值
+     * @param  probes 每张表探测翻转 1 位的邻桶数（0 ~ key_bits），越大召回越高
+     * @param  ratios 可选输出，与返回值一一对应的 d1 / d2（同 myHammingRatioMatch）
+     * @return        DMatch(queryIdx, trainIdx = 该参考图像内的行号, imgIdx = 参考图像编号, distance)
+     */
+    std::vector<cv::DMatch> match(const cv::Mat &query, float ratio, int probes = -1,
+                                  std::vector<float> *ratios = nullptr) const
+    {
+        if (ratios)
+            ratios->clear();
+        CV_Assert(built_ && query.type() == CV_8U && query.cols == bytes_);
+        if (probes < 0)
+            probes = key_bits_;
+        probes = std::min(probes, key_bits_);
+
+        std::vector<HammingBest2> best(query.rows);
+        cv::parallel_for_(cv::Range(0, query.rows), [&](const cv::Range &range)
+                          {
+            // 每个线程一个访问标记数组，用递增的 stamp 去重，不必每个查询清零
+            std::vector<uint32_t> seen(rows_, 0);
+            uint32_t stamp = 0;
+            for (int q = range.start; q < range.end; ++q)
+            {
+                const uchar *qd = query.ptr<uchar>(q);
+                HammingBest2 &b = best[q];
+                ++stamp;
+                for (int t = 0; t < tables_; ++t)
+                {
+                    const uint32_t k0 = key(t, qd);
+                    for (int p = -1; p < probes; ++p)
+                    {
+                        const uint32_t k = p < 0 ? k0 : (k0 ^ (1u << p));
+                        const int *off = offsets_.data() + static_cast<size_t>(t) * ((1 << key_bits_) + 1);
+                        const int *ids = ids_.data() + static_cast<size_t>(t) * rows_;
+                        for (int i = off[k]; i < off[k + 1]; ++i)
+                        {
+                            const int r = ids[i];
+                            if (seen[r] == stamp)
+                                continue;
+                            seen[r] = stamp;
+                            b.push(r, myHammingDistance(qd, row(r), bytes_));
+                        }
+                    }
+                }
+            } });
+
+        std::vector<cv::DMatch> good;
+        for (int q = 0; q < query.rows; ++q)
+        {
+            const HammingBest2 &b = best[q];
+            if (b.idx1 < 0)
+                continue;
+            // 只找到一个候选时没有次近邻可比，视为不可靠
+            if (b.idx2 >= 0 && b.d1 < ratio * b.d2)
+            {
+                const int img = row_image_[b.idx1];
+                good.emplace_back(q, b.idx1 - image_start_[img], img, static_cast<float>(b.d1));
+                if (ratios)
+                    ratios->push_back(b.d2 > 0 ? static_cast<float>(b.d1) / b.d2 : 0.0f);
+            }
+        }
+        return good;
+    }
+
+    int images() const { return static_cast<int>(image_start_.size()); }
+    int size() const { return rows_; }
+
+private:
+    int tables_, key_bits_;
+    uint32_t seed_;
+    int bytes_ = 0, rows_ = 0;
+    bool built_ = false;
+
+    std::vector<uchar> data_;      // 所有参考描述子，逐行连续存放
+    std::vector<int> row_image_;   // 每行属于哪张参考图像
+    std::vector<int> image_start_; // 每张参考图像的起始行
+    std::vector<int> bits_;        // tables x key_bits 个采样位
+    std::vector<int> offsets_;     // tables x (2^key_bits + 1) 桶偏移
+    std::vector<int> ids_;         // tables x rows 行号
+
+    const uchar *row(int r) const { return data_.data() + static_cast<size_t>(r) * bytes_; }
+
+    uint32_t key(int t, const uchar *d) const
+    {
+        const int *bits = bits_.data() + t * key_bits_;
+        uint32_t k = 0;
+        for (int i = 0; i < key_bits_; ++i)
+            k |= static_cast<uint32_t>((d[bits[i] >> 3] >> (bits[i] & 7)) & 1) << i;
+        return k;
+    }
+};
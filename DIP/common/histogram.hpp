@@ -0,0 +1,248 @@
+#pragma once
+
+// histogram.hpp
+// 8 位灰度直方图服务：均衡化、Otsu、多阈值 Otsu 与直方图绘制共用
+//
+//   - 计数：++hist[v] 在相邻像素灰度相同时形成"存储 -> 加载"依赖链（同一地址的读改写必须串行）。
+//     每个线程用 4 张交错的子直方图，相邻像素落到不同的子表，依赖链断开；一次读 8 个像素再逐字节拆出
+//   - 合并：各线程的局部直方图按灰度区间并行累加
+//   - 前缀：整数累计分布 W[k] = sum_{i<=k} h[i] 与一阶矩 M[k] = sum_{i<=k} i*h[i]，
+//     任意区间 [a, b] 的像素数和灰度和都是两次相减
+//   - 查找表映射后的直方图直接由原直方图推出（out[lut[v]] += h[v]），不必再扫一遍图像
+//   - 多阈值 Otsu：区间划分上的动态规划，分治优化后 O(K L log L)
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using Histogram256 = std::array<int, 256>;
+
+/*
+ * @function histogramAccumulate
+ * @brief  把 n 个字节计入 4 张交错子直方图 sub[0..3]（不清零）
+ */
+inline void histogramAccumulate(const uint8_t *p, size_t n, uint32_t (*sub)[256])
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        ++sub[0][w & 0xff];
+        ++sub[1][(w >> 8) & 0xff];
+        ++sub[2][(w >> 16) & 0xff];
+        ++sub[3][(w >> 24) & 0xff];
+        ++sub[0][(w >> 32) & 0xff];
+        ++sub[1][(w >> 40) & 0xff];
+        ++sub[2][(w >> 48) & 0xff];
+        ++sub[3][w >> 56];
+    }
+    for (; i < n; ++i)
+        ++sub[i & 3][p[i]];
+}
+
+/*
+ * @function myHistogram256
+ * @brief  8 位图像的灰度直方图（对应 calcHist 256 bins，但直接给出整数计数）
+ * @param  img CV_8U 图像（多通道时所有通道一起统计）
+ */
+inline Histogram256 myHistogram256(const cv::Mat &img)
+{
+    CV_Assert(img.depth() == CV_8U);
+    const size_t row_bytes = static_cast<size_t>(img.cols) * img.elemSize();
+    // 每个条带至少 64 KB，避免小图上线程开销超过计数本身
+    const int stripes = std::max(1, std::min(cv::getNumThreads(),
+                                             static_cast<int>(row_bytes * img.rows / (1 << 16))));
+
+    std::vector<Histogram256> parts(stripes);
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range &r)
+                      {
+        for (int s = r.start; s < r.end; ++s)
+        {
+            uint32_t sub[4][256] = {};
+            const int y0 = static_cast<int>(static_cast<int64_t>(img.rows) * s / stripes);
+            const int y1 = static_cast<int>(static_cast<int64_t>(img.rows) * (s + 1) / stripes);
+            if (img.isContinuous())
+                histogramAccumulate(img.ptr<uint8_t>(y0), row_bytes * (y1 - y0), sub);
+            else
+                for (int y = y0; y < y1; ++y)
+                    histogramAccumulate(img.ptr<uint8_t>(y), row_bytes, sub);
+            for (int v = 0; v < 256; ++v)
+                parts[s][v] = static_cast<int>(sub[0][v] + sub[1][v] + sub[2][v] + sub[3][v]);
+        } });
+
+    if (stripes == 1)
+        return parts[0];
+
+    // 按灰度区间并行合并（每个线程负责 64 个灰度）
+    Histogram256 hist;
+    cv::parallel_for_(cv::Range(0, 4), [&](const cv::Range &r)
+                      {
+        for (int v = r.start * 64; v < r.end * 64; ++v)
+        {
+            int sum = 0;
+            for (const auto &p : parts)
+                sum += p[v];
+            hist[v] = sum;
+        } });
+    return hist;
+}
+
+/*
+ * @struct HistogramPrefix
+ * @brief  直方图的整数前缀：W[k] 为灰度 <= k 的像素数（即 CDF），M[k] 为这些像素的灰度和
+ */
+struct HistogramPrefix
+{
+    std::array<int64_t, 256> W, M;
+
+    int64_t total() const { return W[255]; }
+    // 区间 [a, b] 的像素数与灰度和
+    int64_t count(int a, int b) const { return W[b] - (a > 0 ? W[a - 1] : 0); }
+    int64_t sum(int a, int b) const { return M[b] - (a > 0 ? M[a - 1] : 0); }
+};
+
+inline HistogramPrefix myHistogramPrefix(const Histogram256 &hist)
+{
+    HistogramPrefix p;
+    int64_t w = 0, m = 0;
+    for (int v = 0; v < 256; ++v)
+    {
+        w += hist[v];
+        m += static_cast<int64_t>(v) * hist[v];
+        p.W[v] = w;
+        p.M[v] = m;
+    }
+    return p;
+}
+
+/*
+ * @function myHistogramOfLut
+ * @brief  图像经查找表映射后的直方图，由原直方图直接推出
+ */
+inline Histogram256 myHistogramOfLut(const Histogram256 &hist, const uint8_t *lut)
+{
+    Histogram256 out{};
+    for (int v = 0; v < 256; ++v)
+        out[lut[v]] += hist[v];
+    return out;
+}
+
+/*
+ * @function myOtsuThreshold
+ * @brief  单阈值 Otsu：使类间方差 q1*q2*(mu1-mu2)^2 最大的 k（像素 > k 为前景，与 THRESH_OTSU 一致）
+ */
+inline int myOtsuThreshold(const HistogramPrefix &p)
+{
+    const double n = static_cast<double>(p.total());
+    double best = 0;
+    int k_best = 0;
+    for (int k = 0; k < 255; ++k)
+    {
+        const int64_t w1 = p.W[k], w2 = p.total() - w1;
+        if (w1 == 0 || w2 == 0)
+            continue;
+        const double mu1 = static_cast<double>(p.M[k]) / w1;
+        const double mu2 = static_cast<double>(p.M[255] - p.M[k]) / w2;
+        const double sigma = (w1 / n) * (w2 / n) * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > best)
+        {
+            best = sigma;
+            k_best = k;
+        }
+    }
+    return k_best;
+}
+
+/*
+ * @function multiOtsuPartition
+ * @brief  K 阈值 Otsu 的核心：把 L 个有序灰度（前缀 W、M）分成 K+1 段，使 sum_j S_j^2 / N_j 最大
+ * @param  W 像素数前缀（长度 L）
+ * @param  M 灰度和前缀（长度 L）
+ * @param  L 灰度个数
+ * @param  k 阈值个数（1 <= k < L）
+ * @return   每段最后一个灰度的下标（递增的 K 个）
+ * @note   类间方差 = sum_j S_j^2 / N_j - const（S_j、N_j 为第 j 类的灰度和、像素数），各类的项只依赖区间端点，
+ *         因此是区间划分上的动态规划：f[c][b] = max_a f[c-1][a-1] + S(a,b)^2/N(a,b)。
+ *         该项满足四边形不等式，最优分割点 a 随 b 单调不减，每一层用分治在 O(L log L) 内求出，
+ *         总计 O(K L log L)；区间项由前缀和两次相减得到，不需要 L x L 的表
+ */
+inline std::vector<int> multiOtsuPartition(const int64_t *W, const int64_t *M, int L, int k)
+{
+    CV_Assert(k >= 1 && k < L);
+    const int classes = k + 1;
+
+    // 区间 [a, b] 的类间项；空区间为 0
+    auto term = [&](int a, int b)
+    {
+        const int64_t n = W[b] - (a > 0 ? W[a - 1] : 0);
+        if (n == 0)
+            return 0.0;
+        const double s = static_cast<double>(M[b] - (a > 0 ? M[a - 1] : 0));
+        return s * s / n;
+    };
+
+    // f[c*L + b]：前 b+1 个灰度分成 c+1 类的最优值；arg[c*L + b]：第 c+1 类的起点
+    std::vector<double> f(static_cast<size_t>(classes) * L);
+    std::vector<int> arg(static_cast<size_t>(classes) * L);
+    for (int b = 0; b < L; ++b)
+        f[b] = term(0, b);
+
+    for (int c = 1; c < classes; ++c)
+    {
+        const double *prev = &f[static_cast<size_t>(c - 1) * L];
+        double *cur = &f[static_cast<size_t>(c) * L];
+        int *cur_arg = &arg[static_cast<size_t>(c) * L];
+        // 计算 b in [lo, hi]，已知最优起点落在 [opt_lo, opt_hi]
+        auto solve = [&](auto &&self, int lo, int hi, int opt_lo, int opt_hi) -> void
+        {
+            if (lo > hi)
+                return;
+            const int mid = (lo + hi) / 2;
+            double best = -1;
+            int best_a = std::max(opt_lo, c);
+            for (int a = std::max(opt_lo, c); a <= std::min(mid, opt_hi); ++a)
+            {
+                const double v = prev[a - 1] + term(a, mid);
+                if (v > best)
+                {
+                    best = v;
+                    best_a = a;
+                }
+            }
+            cur[mid] = best;
+            cur_arg[mid] = best_a;
+            self(self, lo, mid - 1, opt_lo, best_a);
+            self(self, mid + 1, hi, best_a, opt_hi);
+        };
+        // 前 b+1 个灰度至少要能分成 c+1 个非空区间
+        solve(solve, c, L - 1, c, L - 1);
+    }
+
+    // 回溯：第 c+1 类的起点 a 对应阈值 a-1
+    std::vector<int> thresholds(k);
+    int b = L - 1;
+    for (int c = classes - 1; c >= 1; --c)
+    {
+        const int a = arg[static_cast<size_t>(c) * L + b];
+        thresholds[c - 1] = a - 1;
+        b = a - 1;
+    }
+    return thresholds;
+}
+
+/*
+ * @function myMultiOtsuThresholds
+ * @brief  K 阈值 Otsu：把 [0, 255] 分成 K+1 类，使类间方差最大
+ * @param  p 直方图前缀
+ * @param  k 阈值个数（1 <= k < 256）
+ * @return   递增的 K 个阈值 t_1 < ... < t_K，第 j 类为 (t_{j-1}, t_j]
+ */
+inline std::vector<int> myMultiOtsuThresholds(const HistogramPrefix &p, int k)
+{
+    return multiOtsuPartition(p.W.data(), p.M.data(), 256, k);
+}
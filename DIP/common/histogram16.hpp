@@ -0,0 +1,315 @@
+#pragma once
+
+// histogram16.hpp
+// 16 位（12~16 位有效）灰度的直方图、均衡化与 Otsu
+//
+// X 光、CT 数据是 12~16 位的，65536 个 bin 的直方图（每线程 256 KB）和 65536 项的查找表都放不进 L1/L2。
+// 实际数据只占值域的一小段（12 位数据只用到 16 个高字节），因此都做成两级：
+//   - 直方图：粗层按高字节分 256 个桶；细层（低字节 256 个 bin）只给出现过的桶分配，首次遇到时才分配
+//   - 前缀：只对出现过的灰度建立压缩的 (灰度, W, M) 数组，Otsu / 多阈值 Otsu 在压缩数组上计算
+//   - 查找表：同样按高字节分桶，只存出现过的桶；应用时 base[v >> 8] + (v & 255) 两次查表。
+//     两张表合计通常只有几 KB，标量查表已在 L1 内；AVX2 gather 实测不比标量快，因此不做向量化
+//   - 阈值分割不建表，逐像素与 K 个阈值比较（AVX2 一次 16 个像素），类别号经 vpshufb 映射为输出灰度
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "histogram.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * @struct Histogram16
+ * @brief  两级 16 位直方图：coarse[h] 为高字节为 h 的像素数，fine[slot[h]][l] 为灰度 (h << 8) | l 的像素数
+ */
+struct Histogram16
+{
+    std::array<int64_t, 256> coarse{};
+    std::array<int, 256> slot;                  // 桶 -> 细层下标，-1 表示该桶没有像素
+    std::vector<std::array<uint32_t, 256>> fine; // 按桶号升序
+
+    Histogram16() { slot.fill(-1); }
+
+    int64_t total() const
+    {
+        int64_t n = 0;
+        for (auto c : coarse)
+            n += c;
+        return n;
+    }
+
+    // 按灰度升序遍历出现过的灰度：f(value, count)
+    template <typename F>
+    void forEach(F &&f) const
+    {
+        for (int h = 0; h < 256; ++h)
+        {
+            if (slot[h] < 0)
+                continue;
+            const auto &bins = fine[slot[h]];
+            for (int l = 0; l < 256; ++l)
+                if (bins[l])
+                    f((h << 8) | l, bins[l]);
+        }
+    }
+};
+
+/*
+ * @function myHistogram16
+ * @brief  CV_16UC1 图像的两级直方图（按行条带并行，细层在条带内按需分配，最后按桶合并）
+ */
+inline Histogram16 myHistogram16(const cv::Mat &img)
+{
+    CV_Assert(img.type() == CV_16UC1);
+    const int stripes = std::max(1, std::min(cv::getNumThreads(),
+                                             static_cast<int>(static_cast<int64_t>(img.total()) / (1 << 15))));
+
+    std::vector<Histogram16> parts(stripes);
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range &r)
+                      {
+        for (int s = r.start; s < r.end; ++s)
+        {
+            Histogram16 &h = parts[s];
+            h.fine.reserve(16);
+            const int y0 = static_cast<int>(static_cast<int64_t>(img.rows) * s / stripes);
+            const int y1 = static_cast<int>(static_cast<int64_t>(img.rows) * (s + 1) / stripes);
+            for (int y = y0; y < y1; ++y)
+            {
+                const uint16_t *p = img.ptr<uint16_t>(y);
+                for (int x = 0; x < img.cols; ++x)
+                {
+                    const int hi = p[x] >> 8;
+                    int k = h.slot[hi];
+                    if (k < 0)
+                    {
+                        k = h.slot[hi] = static_cast<int>(h.fine.size());
+                        h.fine.push_back({});
+                    }
+                    ++h.fine[k][p[x] & 0xff];
+                }
+            }
+            for (int hi = 0; hi < 256; ++hi)
+                if (h.slot[hi] >= 0)
+                    for (uint32_t c : h.fine[h.slot[hi]])
+                        h.coarse[hi] += c;
+        } });
+
+    // 合并：细层按桶号升序重新编号，各桶并行累加
+    Histogram16 out;
+    std::vector<int> buckets;
+    for (int hi = 0; hi < 256; ++hi)
+    {
+        for (const auto &p : parts)
+            out.coarse[hi] += p.coarse[hi];
+        if (out.coarse[hi] > 0)
+        {
+            out.slot[hi] = static_cast<int>(buckets.size());
+            buckets.push_back(hi);
+        }
+    }
+    out.fine.assign(buckets.size(), {});
+    cv::parallel_for_(cv::Range(0, static_cast<int>(buckets.size())), [&](const cv::Range &r)
+                      {
+        for (int b = r.start; b < r.end; ++b)
+        {
+            const int hi = buckets[b];
+            for (const auto &p : parts)
+                if (p.slot[hi] >= 0)
+                    for (int l = 0; l < 256; ++l)
+                        out.fine[b][l] += p.fine[p.slot[hi]][l];
+        } });
+    return out;
+}
+
+/*
+ * @struct Histogram16Prefix
+ * @brief  只含出现过的灰度的压缩前缀：value[i] 升序，W[i]、M[i] 为灰度 <= value[i] 的像素数与灰度和
+ */
+struct Histogram16Prefix
+{
+    std::vector<uint16_t> value;
+    std::vector<int64_t> W, M;
+
+    int size() const { return static_cast<int>(value.size()); }
+    int64_t total() const { return W.empty() ? 0 : W.back(); }
+};
+
+inline Histogram16Prefix myHistogram16Prefix(const Histogram16 &hist)
+{
+    Histogram16Prefix p;
+    int64_t w = 0, m = 0;
+    hist.forEach([&](int v, uint32_t c)
+                 {
+        w += c;
+        m += static_cast<int64_t>(v) * c;
+        p.value.push_back(static_cast<uint16_t>(v));
+        p.W.push_back(w);
+        p.M.push_back(m); });
+    return p;
+}
+
+/*
+ * @function myOtsuThreshold16
+ * @brief  16 位单阈值 Otsu：像素 > 阈值为前景
+ * @note   没有像素的灰度不改变 W、M，类间方差在两个相邻的出现值之间不变，只需在出现过的灰度上求最大
+ */
+inline int myOtsuThreshold16(const Histogram16Prefix &p)
+{
+    const int64_t total = p.total();
+    const double n = static_cast<double>(total);
+    double best = 0;
+    int k_best = p.size() > 0 ? p.value[0] : 0;
+    for (int i = 0; i + 1 < p.size(); ++i)
+    {
+        const int64_t w1 = p.W[i], w2 = total - w1;
+        const double mu1 = static_cast<double>(p.M[i]) / w1;
+        const double mu2 = static_cast<double>(p.M.back() - p.M[i]) / w2;
+        const double sigma = (w1 / n) * (w2 / n) * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > best)
+        {
+            best = sigma;
+            k_best = p.value[i];
+        }
+    }
+    return k_best;
+}
+
+/*
+ * @function myMultiOtsuThresholds16
+ * @brief  16 位 K 阈值 Otsu（动态规划在压缩前缀上进行，规模为出现过的灰度数）
+ * @return 递增的 K 个阈值（灰度值）；出现过的灰度少于 K+1 个时返回空
+ */
+inline std::vector<int> myMultiOtsuThresholds16(const Histogram16Prefix &p, int k)
+{
+    if (p.size() < k + 1)
+        return {};
+    std::vector<int> idx = multiOtsuPartition(p.W.data(), p.M.data(), p.size(), k);
+    for (auto &t : idx)
+        t = p.value[t];
+    return idx;
+}
+
+/*
+ * @struct Lut16
+ * @brief  两级 16 位查找表：灰度 v 的输出为 table[base[v >> 8] + (v & 255)]，只存出现过的桶
+ */
+struct Lut16
+{
+    std::array<int32_t, 256> base{};
+    std::vector<uint16_t> table;
+
+    explicit Lut16(const Histogram16 &hist)
+    {
+        table.assign(std::max<size_t>(hist.fine.size(), 1) * 256, 0);
+        for (int h = 0; h < 256; ++h)
+            base[h] = hist.slot[h] >= 0 ? hist.slot[h] * 256 : 0;
+    }
+
+    uint16_t &at(int v) { return table[base[v >> 8] + (v & 0xff)]; }
+    uint16_t operator()(int v) const { return table[base[v >> 8] + (v & 0xff)]; }
+};
+
+/*
+ * @function myApplyLut16
+ * @brief  对 CV_16UC1 图像应用两级查找表（表中必须包含图像中出现的所有桶）
+ */
+inline cv::Mat myApplyLut16(const cv::Mat &src, const Lut16 &lut)
+{
+    CV_Assert(src.type() == CV_16UC1);
+    cv::Mat dst(src.size(), CV_16UC1);
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const uint16_t *s = src.ptr<uint16_t>(y);
+            uint16_t *d = dst.ptr<uint16_t>(y);
+            for (int x = 0; x < src.cols; ++x)
+                d[x] = lut(s[x]);
+        } });
+    return dst;
+}
+
+/*
+ * @function myEqualize16
+ * @brief  16 位直方图均衡化：s = round(cdf(v) / N * out_max)
+ * @param  src     CV_16UC1
+ * @param  out_max 输出最大值（默认 65535；12 位数据可取 4095）
+ * @return         CV_16UC1
+ */
+inline cv::Mat myEqualize16(const cv::Mat &src, int out_max = 65535)
+{
+    CV_Assert(src.type() == CV_16UC1 && out_max > 0 && out_max <= 65535);
+    const Histogram16 hist = myHistogram16(src);
+    const Histogram16Prefix p = myHistogram16Prefix(hist);
+    Lut16 lut(hist);
+    const double scale = static_cast<double>(out_max) / p.total();
+    for (int i = 0; i < p.size(); ++i)
+        lut.at(p.value[i]) = static_cast<uint16_t>(std::lround(p.W[i] * scale));
+    return myApplyLut16(src, lut);
+}
+
+/*
+ * @function myApplyThresholds16
+ * @brief  16 位多阈值分割：类别 j（t_{j-1} < v <= t_j）输出 levels[j]
+ * @param  src        CV_16UC1
+ * @param  thresholds 递增的 K 个阈值
+ * @param  levels     K+1 个输出灰度
+ * @return            CV_8UC1
+ */
+inline cv::Mat myApplyThresholds16(const cv::Mat &src, const std::vector<int> &thresholds, const std::vector<uint8_t> &levels)
+{
+    CV_Assert(src.type() == CV_16UC1 && levels.size() == thresholds.size() + 1);
+    const int k = static_cast<int>(thresholds.size());
+    cv::Mat dst(src.size(), CV_8UC1);
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const uint16_t *s = src.ptr<uint16_t>(y);
+            uint8_t *d = dst.ptr<uint8_t>(y);
+            int x = 0;
+#if defined(__AVX2__)
+            if (k <= 15)
+            {
+                // 无符号比较：两边都异或 0x8000 后用有符号 cmpgt；类别号 = 大于的阈值个数，再经 vpshufb 查 levels
+                const __m256i flip = _mm256_set1_epi16(static_cast<int16_t>(0x8000));
+                __m256i th[15];
+                for (int j = 0; j < k; ++j)
+                    th[j] = _mm256_set1_epi16(static_cast<int16_t>(thresholds[j] ^ 0x8000));
+                alignas(16) uint8_t lv[16] = {};
+                for (int j = 0; j <= k; ++j)
+                    lv[j] = levels[j];
+                const __m256i table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(lv)));
+                for (; x + 32 <= src.cols; x += 32)
+                {
+                    __m256i v0 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + x)), flip);
+                    __m256i v1 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + x + 16)), flip);
+                    __m256i c0 = _mm256_setzero_si256(), c1 = _mm256_setzero_si256();
+                    for (int j = 0; j < k; ++j)
+                    {
+                        // cmpgt 为真时是 -1，减去即计数加 1
+                        c0 = _mm256_sub_epi16(c0, _mm256_cmpgt_epi16(v0, th[j]));
+                        c1 = _mm256_sub_epi16(c1, _mm256_cmpgt_epi16(v1, th[j]));
+                    }
+                    __m256i c = _mm256_permute4x64_epi64(_mm256_packus_epi16(c0, c1), 0xD8);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + x), _mm256_shuffle_epi8(table, c));
+                }
+            }
+#endif
+            for (; x < src.cols; ++x)
+            {
+                int c = 0;
+                while (c < k && s[x] > thresholds[c])
+                    ++c;
+                d[x] = levels[c];
+            }
+        } });
+    return dst;
+}
@@ -0,0 +1,521 @@
+#pragma once
+
+// homography.hpp
+// 鲁棒单应矩阵估计：PROSAC 采样 + SPRT 提前拒绝 + SoA/SIMD 批量打分 + 多线程并行评估假设
+//
+//   - PROSAC：对应点按匹配质量（比率测试的 d1/d2，越小越好）排序，先从最可靠的前 n 个点中采样，
+//     n 按 PROSAC 的增长函数逐步扩大到全部点；内点率低时也能很快采到好样本
+//   - SPRT：打分时每验证 64 个点做一次序贯概率比检验，明显是坏模型的假设不必看完全部点
+//   - 打分：点以 SoA（x[], y[], u[], v[]）存放，AVX2 一次验证 8 个点，内点用 movemask + popcount 计数
+//   - 并行：每一轮按 PROSAC 顺序串行生成一批样本（很便宜），再用 cv::parallel_for_ 并行求解与打分；
+//     同一批内按假设编号决胜，结果与线程数无关
+//   - 所有点先做一次全局归一化（平移到质心、平均距离 sqrt(2)），最小解与打分都在归一化坐标下进行
+// 结束后用全部内点最小二乘重新拟合，返回内点掩码与迭代 / 耗时统计。
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * @struct HomographyParams
+ * @brief  鲁棒估计参数
+ */
+struct HomographyParams
+{
+    double reproj_threshold = 3.0; // 重投影误差阈值（像素），与 findHomography 的默认值相同
+    double confidence = 0.995;     // 自适应终止的置信度
+    int max_iters = 2000;          // 最多采样次数
+    int batch = 64;                // 每轮并行评估的假设数
+    uint32_t seed = 0x484F4D;      // 随机数种子（结果可复现）
+};
+
+/*
+ * @struct HomographyStats
+ * @brief  估计过程的统计，用于观察延迟长尾
+ */
+struct HomographyStats
+{
+    int iterations = 0;     // 采样次数
+    int models = 0;         // 实际求解并打分的模型数
+    int degenerate = 0;     // 退化样本（共线 / 方向不一致）数
+    int sprt_rejected = 0;  // 被 SPRT 提前拒绝的模型数
+    long long verified = 0; // 打分时累计验证的点数（SPRT 的代价：完整验证一个模型为 N 个点）
+    int inliers = 0;        // 最终内点数
+    double elapsed_ms = 0;  // 总耗时
+};
+
+// 8x9 增广矩阵的高斯消元（列主元），解出 h0..h7（h8 = 1）
+inline bool homographySolve8(double A[8][9], double h[8])
+{
+    for (int c = 0; c < 8; ++c)
+    {
+        int piv = c;
+        for (int r = c + 1; r < 8; ++r)
+            if (std::abs(A[r][c]) > std::abs(A[piv][c]))
+                piv = r;
+        if (std::abs(A[piv][c]) < 1e-12)
+            return false;
+        if (piv != c)
+            for (int k = 0; k < 9; ++k)
+                std::swap(A[c][k], A[piv][k]);
+        for (int r = c + 1; r < 8; ++r)
+        {
+            double f = A[r][c] / A[c][c];
+            if (f == 0.0)
+                continue;
+            for (int k = c; k < 9; ++k)
+                A[r][k] -= f * A[c][k];
+        }
+    }
+    for (int c = 7; c >= 0; --c)
+    {
+        double s = A[c][8];
+        for (int k = c + 1; k < 8; ++k)
+            s -= A[c][k] * h[k];
+        h[c] = s / A[c][c];
+    }
+    return true;
+}
+
+/*
+ * @class HomographyEstimator
+ * @brief  对一组对应点做鲁棒估计（内部使用，外部调用 myFindHomographyRobust）
+ */
+class HomographyEstimator
+{
+public:
+    HomographyEstimator(const std::vector<cv::Point2f> &src, const std::vector<cv::Point2f> &dst,
+                        const std::vector<float> &scores, const HomographyParams &params)
+        : params_(params), n_(static_cast<int>(src.size()))
+    {
+        // PROSAC 顺序：分数升序（稳定排序，分数相同时保持原顺序）
+        order_.resize(n_);
+        std::iota(order_.begin(), order_.end(), 0);
+        if (scores.size() == src.size())
+            std::stable_sort(order_.begin(), order_.end(), [&](int a, int b)
+                             { return scores[a] < scores[b]; });
+
+        normalize(src, t1_);
+        normalize(dst, t2_);
+
+        // SoA，长度补齐到 8 的倍数；补齐的点目标设为极远，永远不是内点
+        const int padded = (n_ + 7) & ~7;
+        x_.assign(padded, 0.0f);
+        y_.assign(padded, 0.0f);
+        u_.assign(padded, 1e30f);
+        v_.assign(padded, 1e30f);
+        for (int i = 0; i < n_; ++i)
+        {
+            const int j = order_[i];
+            x_[i] = static_cast<float>(t1_[0] * src[j].x + t1_[1]);
+            y_[i] = static_cast<float>(t1_[0] * src[j].y + t1_[2]);
+            u_[i] = static_cast<float>(t2_[0] * dst[j].x + t2_[1]);
+            v_[i] = static_cast<float>(t2_[0] * dst[j].y + t2_[2]);
+        }
+        // 像素阈值换算到归一化的目标坐标
+        const double thr = params_.reproj_threshold * t2_[0];
+        thr2_ = static_cast<float>(thr * thr);
+    }
+
+    cv::Mat run(std::vector<uchar> *mask, HomographyStats &stats)
+    {
+        constexpr int m = 4;
+        std::mt19937 rng(params_.seed);
+
+        // PROSAC 增长函数：T_n 为只从前 n 个点采样时的期望样本数，Tp 为切换到 n+1 的迭代次数
+        double Tn = params_.max_iters;
+        for (int i = 0; i < m; ++i)
+            Tn *= static_cast<double>(m - i) / (n_ - i);
+        int n = m;
+        double Tp = 1.0;
+
+        // SPRT 参数：eps 为好模型的内点率，delta 为坏模型的内点率
+        double eps = 0.1, delta = 0.01;
+        double delta_sum = 0.0;
+        int delta_count = 0;
+        double logA = sprtThreshold(eps, delta);
+
+        std::vector<double> best_h(9, 0.0);
+        int best_inliers = -1;
+        long long max_iters = params_.max_iters;
+        int it = 0;
+
+        std::vector<std::array<int, 4>> samples;
+        std::vector<std::array<double, 9>> models;
+        std::vector<int> scores, seen;
+
+        while (it < max_iters)
+        {
+            // 1. 串行生成一批样本
+            const int B = static_cast<int>(std::min<long long>(params_.batch, max_iters - it));
+            samples.resize(B);
+            for (int b = 0; b < B; ++b, ++it)
+            {
+                if (it + 1 >= Tp && n < n_)
+                {
+                    // 切换到前 n+1 个点
+                    double Tn1 = Tn * (n + 1) / (n + 1 - m);
+                    Tp += std::ceil(Tn1 - Tn);
+                    Tn = Tn1;
+                    ++n;
+                }
+                std::array<int, 4> &s = samples[b];
+                // PROSAC：第 n 个点必选，其余 3 个从前 n-1 个中选；n 到 N 后退化为普通随机采样
+                const bool prosac = n < n_;
+                const int pool = prosac ? n - 1 : n_;
+                int k = 0;
+                if (prosac)
+                    s[k++] = n - 1;
+                while (k < m)
+                {
+                    int c = static_cast<int>(rng() % pool);
+                    bool dup = false;
+                    for (int j = 0; j < k; ++j)
+                        dup |= s[j] == c;
+                    if (!dup)
+                        s[k++] = c;
+                }
+            }
+
+            // 2. 并行求解与打分：scores == -1 表示退化，-2 表示被 SPRT 拒绝；seen 为实际验证的点数，计入 stats.verified
+            models.resize(B);
+            scores.assign(B, 0);
+            seen.assign(B, 0);
+            cv::parallel_for_(cv::Range(0, B), [&](const cv::Range &range)
+                              {
+                for (int b = range.start; b < range.end; ++b)
+                {
+                    if (!minimalSolve(samples[b], models[b].data()))
+                    {
+                        scores[b] = -1;
+                        continue;
+                    }
+                    scores[b] = score(models[b].data(), eps, delta, logA, seen[b]);
+                } });
+
+            // 3. 归并（按假设编号顺序，结果与线程数无关）
+            bool improved = false;
+            for (int b = 0; b < B; ++b)
+            {
+                if (scores[b] == -1)
+                {
+                    ++stats.degenerate;
+                    continue;
+                }
+                ++stats.models;
+                stats.verified += seen[b];
+                if (scores[b] == -2)
+                {
+                    ++stats.sprt_rejected;
+                    continue;
+                }
+                if (scores[b] > best_inliers)
+                {
+                    best_inliers = scores[b];
+                    std::copy(models[b].begin(), models[b].end(), best_h.begin());
+                    improved = true;
+                }
+                else
+                {
+                    // 验证完但不是最好的模型，用于估计坏模型的内点率
+                    delta_sum += static_cast<double>(scores[b]) / n_;
+                    ++delta_count;
+                }
+            }
+
+            // 4. 更新 SPRT 参数与自适应终止条件
+            if (improved)
+                eps = std::max(eps, static_cast<double>(best_inliers) / n_);
+            if (delta_count > 0)
+                delta = delta_sum / delta_count;
+            delta = std::clamp(delta, 1e-3, eps * 0.9);
+            logA = sprtThreshold(eps, delta);
+            if (improved)
+            {
+                const double w = static_cast<double>(best_inliers) / n_;
+
+                // 好模型被 SPRT 误拒的概率约为 1/A，计入每次采样成功的概率
+                const double p_good = std::pow(w, m) * (1.0 - std::exp(-logA));
+                if (p_good > 1e-12)
+                {
+                    const double need = std::log(1.0 - params_.confidence) / std::log(std::max(1e-12, 1.0 - p_good));
+                    max_iters = std::min<long long>(max_iters, static_cast<long long>(std::ceil(need)));
+                }
+            }
+        }
+        stats.iterations = it;
+
+        if (best_inliers < m)
+            return cv::Mat();
+
+        // 用全部内点最小二乘重新拟合；若内点反而变少则保留最小解
+        std::vector<uchar> in(n_);
+        int cnt = classify(best_h.data(), in.data());
+        std::vector<double> refined(9);
+        if (leastSquares(in.data(), refined.data()))
+        {
+            std::vector<uchar> in2(n_);
+            int cnt2 = classify(refined.data(), in2.data());
+            if (cnt2 >= cnt)
+            {
+                best_h = refined;
+                in.swap(in2);
+                cnt = cnt2;
+            }
+        }
+        stats.inliers = cnt;
+
+        if (mask)
+        {
+            mask->assign(n_, 0);
+            for (int i = 0; i < n_; ++i)
+                (*mask)[order_[i]] = in[i];
+        }
+        return denormalize(best_h.data());
+    }
+
+private:
+    HomographyParams params_;
+    int n_;
+    std::vector<int> order_;              // 第 i 个（排序后）点对应的原始下标
+    std::vector<float> x_, y_, u_, v_;    // 归一化后的 SoA 坐标
+    double t1_[3], t2_[3];                // 归一化：p' = s * p + (tx, ty)
+    float thr2_;
+
+    static void normalize(const std::vector<cv::Point2f> &p, double t[3])
+    {
+        double cx = 0, cy = 0;
+        for (const auto &q : p)
+        {
+            cx += q.x;
+            cy += q.y;
+        }
+        cx /= p.size();
+        cy /= p.size();
+        double d = 0;
+        for (const auto &q : p)
+            d += std::hypot(q.x - cx, q.y - cy);
+        d /= p.size();
+        const double s = d > 1e-12 ? std::sqrt(2.0) / d : 1.0;
+        t[0] = s;
+        t[1] = -s * cx;
+        t[2] = -s * cy;
+    }
+
+    // SPRT 判决阈值 A：A = K + 1 + ln A 的不动点，K 取模型求解耗时与单点验证耗时之比乘以 C
+    static double sprtThreshold(double eps, double delta)
+    {
+        const double C = (1 - delta) * std::log((1 - delta) / (1 - eps)) + delta * std::log(delta / eps);
+        const double K = 200.0 * C;
+        double A = K + 1;
+        for (int i = 0; i < 10; ++i)
+            A = K + 1 + std::log(A);
+        return std::log(std::max(A, 1.0 + 1e-9));
+    }
+
+    // 两组点中任意三点的朝向必须一致且不共线，否则样本退化
+    bool goodSample(const std::array<int, 4> &s) const
+    {
+        static const int tri[4][3] = {{0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3}};
+        for (const auto &t : tri)
+        {
+            const int a = s[t[0]], b = s[t[1]], c = s[t[2]];
+            double c1 = (x_[b] - x_[a]) * (y_[c] - y_[a]) - (y_[b] - y_[a]) * (x_[c] - x_[a]);
+            double c2 = (u_[b] - u_[a]) * (v_[c] - v_[a]) - (v_[b] - v_[a]) * (u_[c] - u_[a]);
+            if (std::abs(c1) < 1e-6 || std::abs(c2) < 1e-6 || (c1 > 0) != (c2 > 0))
+                return false;
+        }
+        return true;
+    }
+
+    bool minimalSolve(const std::array<int, 4> &s, double *h) const
+    {
+        if (!goodSample(s))
+            return false;
+        double A[8][9];
+        for (int k = 0; k < 4; ++k)
+        {
+            const double x = x_[s[k]], y = y_[s[k]], u = u_[s[k]], v = v_[s[k]];
+            double r0[9] = {x, y, 1, 0, 0, 0, -u * x, -u * y, u};
+            double r1[9] = {0, 0, 0, x, y, 1, -v * x, -v * y, v};
+            std::copy(r0, r0 + 9, A[2 * k]);
+            std::copy(r1, r1 + 9, A[2 * k + 1]);
+        }
+        if (!homographySolve8(A, h))
+            return false;
+        h[8] = 1.0;
+        return true;
+    }
+
+    /*
+     * @function score
+     * @brief  统计内点数；每 64 个点做一次 SPRT 检验
+     * @return 内点数；被 SPRT 拒绝时返回 -2
+     * @param  seen 返回实际验证的点数（被拒绝时小于 n_）
+     */
+    int score(const double *hd, double eps, double delta, double logA, int &seen) const
+    {
+        float h[9];
+        for (int i = 0; i < 9; ++i)
+            h[i] = static_cast<float>(hd[i]);
+        const double log_in = std::log(delta / eps), log_out = std::log((1 - delta) / (1 - eps));
+        const int padded = static_cast<int>(x_.size());
+        double loglambda = 0.0;
+        int inliers = 0;
+
+        for (int i0 = 0; i0 < padded; i0 += 64)
+        {
+            const int i1 = std::min(i0 + 64, padded);
+            const int block_in = countInliers(h, i0, i1);
+            const int block_n = std::min(i1, n_) - i0;
+            inliers += block_in;
+            loglambda += block_in * log_in + (block_n - block_in) * log_out;
+            if (loglambda > logA)
+            {
+                seen = std::min(i1, n_);
+                return -2;
+            }
+        }
+        seen = n_;
+        return inliers;
+    }
+
+    // [i0, i1) 内的内点数（i0、i1 为 8 的倍数）
+    int countInliers(const float *h, int i0, int i1) const
+    {
+        int cnt = 0;
+        int i = i0;
+#if defined(__AVX2__)
+        const __m256 h0 = _mm256_set1_ps(h[0]), h1 = _mm256_set1_ps(h[1]), h2 = _mm256_set1_ps(h[2]);
+        const __m256 h3 = _mm256_set1_ps(h[3]), h4 = _mm256_set1_ps(h[4]), h5 = _mm256_set1_ps(h[5]);
+        const __m256 h6 = _mm256_set1_ps(h[6]), h7 = _mm256_set1_ps(h[7]), h8 = _mm256_set1_ps(h[8]);
+        const __m256 thr = _mm256_set1_ps(thr2_);
+        for (; i < i1; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(&x_[i]), y = _mm256_loadu_ps(&y_[i]);
+            __m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(h6, x), _mm256_mul_ps(h7, y)), h8);
+            __m256 px = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(h0, x), _mm256_mul_ps(h1, y)), h2);
+            __m256 py = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(h3, x), _mm256_mul_ps(h4, y)), h5);
+            __m256 dx = _mm256_sub_ps(_mm256_div_ps(px, w), _mm256_loadu_ps(&u_[i]));
+            __m256 dy = _mm256_sub_ps(_mm256_div_ps(py, w), _mm256_loadu_ps(&v_[i]));
+            __m256 e = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            cnt += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(e, thr, _CMP_LT_OQ))));
+        }
+#endif
+        for (; i < i1; ++i)
+            cnt += inlier(h, i);
+        return cnt;
+    }
+
+    template <typename H>
+    bool inlier(const H *h, int i) const
+    {
+        const float x = x_[i], y = y_[i];
+        const float w = static_cast<float>(h[6] * x + h[7] * y + h[8]);
+        const float dx = static_cast<float>(h[0] * x + h[1] * y + h[2]) / w - u_[i];
+        const float dy = static_cast<float>(h[3] * x + h[4] * y + h[5]) / w - v_[i];
+        return dx * dx + dy * dy < thr2_;
+    }
+
+    int classify(const double *h, uchar *in) const
+    {
+        int cnt = 0;
+        for (int i = 0; i < n_; ++i)
+            cnt += (in[i] = inlier(h, i) ? 1 : 0);
+        return cnt;
+    }
+
+    // 全部内点的 DLT 最小二乘（h8 = 1），解正规方程
+    bool leastSquares(const uchar *in, double *h) const
+    {
+        double A[8][9] = {};
+        int cnt = 0;
+        for (int i = 0; i < n_; ++i)
+        {
+            if (!in[i])
+                continue;
+            ++cnt;
+            const double x = x_[i], y = y_[i], u = u_[i], v = v_[i];
+            const double r0[9] = {x, y, 1, 0, 0, 0, -u * x, -u * y, u};
+            const double r1[9] = {0, 0, 0, x, y, 1, -v * x, -v * y, v};
+            for (int a = 0; a < 8; ++a)
+                for (int b = 0; b < 9; ++b)
+                    A[a][b] += r0[a] * r0[b] + r1[a] * r1[b];
+        }
+        if (cnt < 4 || !homographySolve8(A, h))
+            return false;
+        h[8] = 1.0;
+        return true;
+    }
+
+    // H = T2^-1 * Hn * T1，并使 H(2,2) = 1
+    cv::Mat denormalize(const double *hn) const
+    {
+        // T1 = [s1 0 a1; 0 s1 b1; 0 0 1]，T2^-1 = [1/s2 0 -a2/s2; 0 1/s2 -b2/s2; 0 0 1]
+        double t[9];
+        for (int r = 0; r < 3; ++r)
+        {
+            t[r * 3 + 0] = hn[r * 3 + 0] * t1_[0];
+            t[r * 3 + 1] = hn[r * 3 + 1] * t1_[0];
+            t[r * 3 + 2] = hn[r * 3 + 0] * t1_[1] + hn[r * 3 + 1] * t1_[2] + hn[r * 3 + 2];
+        }
+        cv::Mat H(3, 3, CV_64F);
+        const double is = 1.0 / t2_[0];
+        for (int c = 0; c < 3; ++c)
+        {
+            H.at<double>(0, c) = is * (t[c] - t2_[1] * t[6 + c]);
+            H.at<double>(1, c) = is * (t[3 + c] - t2_[2] * t[6 + c]);
+            H.at<double>(2, c) = t[6 + c];
+        }
+        const double h22 = H.at<double>(2, 2);
+        for (int i = 0; i < 9; ++i)
+            H.at<double>(i / 3, i % 3) /= h22;
+        return H;
+    }
+};
+
+/*
+ * @function myFindHomographyRobust
+ * @brief  PROSAC + SPRT 的鲁棒单应矩阵估计（对应 findHomography(src, dst, RANSAC, thr, mask)）
+ * @param  src    源点（待配准图像中的点）
+ * @param  dst    目标点（参考图像中的点）
+ * @param  scores 每对点的质量分数，越小越可靠（如比率测试的 d1/d2）；为空时按原顺序
+ * @param  mask   可选输出：内点掩码（与输入一一对应，1 为内点）
+ * @param  stats  可选输出：迭代次数、模型数、SPRT 拒绝数、内点数、耗时
+ * @param  params 估计参数
+ * @return        3x3 单应矩阵（CV_64F），失败时为空
+ */
+inline cv::Mat myFindHomographyRobust(const std::vector<cv::Point2f> &src, const std::vector<cv::Point2f> &dst,
+                                      const std::vector<float> &scores = {}, std::vector<uchar> *mask = nullptr,
+                                      HomographyStats *stats = nullptr, const HomographyParams &params = HomographyParams())
+{
+    CV_Assert(src.size() == dst.size());
+    HomographyStats st;
+    auto t0 = std::chrono::steady_clock::now();
+    cv::Mat H;
+    if (src.size() >= 4)
+    {
+        HomographyEstimator est(src, dst, scores, params);
+        H = est.run(mask, st);
+    }
+    else if (mask)
+    {
+        mask->assign(src.size(), 0);
+    }
+    st.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (stats)
+        *stats = st;
+    return H;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// pixel.hpp
+// 像素类型分发：把运行时的 cv::Mat::type() 映射到编译期的 <T, CN> 模板实例，
+// 各个内核按 (深度, 通道数) 生成各自特化的内层循环，调用方不必先做类型转换。
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+/*
+ * @function dispatchChannels
+ * @brief  按通道数调用 f.template operator()<T, CN>()
+ */
+template <typename T, typename F>
+inline void dispatchChannels(int cn, F &&f)
+{
+    switch (cn)
+    {
+    case 1:
+        f.template operator()<T, 1>();
+        break;
+    case 2:
+        f.template operator()<T, 2>();
+        break;
+    case 3:
+        f.template operator()<T, 3>();
+        break;
+    case 4:
+        f.template operator()<T, 4>();
+        break;
+    default:
+        CV_Assert(!"unsupported channel count (1-4)");
+    }
+}
+
+/*
+ * @function myDispatchPixelType
+ * @brief  按 cv::Mat::type() 选择模板实例并调用 f.template operator()<T, CN>()
+ * @param  type 图像类型，如 CV_8UC1、CV_16UC3、CV_32FC4
+ * @param  f    带两个模板参数的泛型 lambda：[&]<typename T, int CN>() { ... }
+ * @note   支持 CV_8U / CV_16U / CV_32F / CV_64F，1~4 通道
+ */
+template <typename F>
+inline void myDispatchPixelType(int type, F &&f)
+{
+    const int cn = CV_MAT_CN(type);
+    switch (CV_MAT_DEPTH(type))
+    {
+    case CV_8U:
+        dispatchChannels<uchar>(cn, f);
+        break;
+    case CV_16U:
+        dispatchChannels<ushort>(cn, f);
+        break;
+    case CV_32F:
+        dispatchChannels<float>(cn, f);
+        break;
+    case CV_64F:
+        dispatchChannels<double>(cn, f);
+        break;
+    default:
+        CV_Assert(!"unsupported depth (CV_8U / CV_16U / CV_32F / CV_64F)");
+    }
+}
+
+/*
+ * @function pixelFromDouble
+ * @brief  把插值结果写回像素类型：整数类型按 std::round（半数远离零）取整并饱和，浮点类型直接转换
+ */
+template <typename T>
+inline T pixelFromDouble(double v)
+{
+    if constexpr (std::is_integral_v<T>)
+    {
+        constexpr double lo = std::numeric_limits<T>::min();
+        constexpr double hi = std::numeric_limits<T>::max();
+        return static_cast<T>(std::clamp(std::round(v), lo, hi));
+    }
+    else
+    {
+        return static_cast<T>(v);
+    }
+}
+
+// float 版本（可分离缩放的累加器为 float）：用 floor(v + 0.5) 取整，便于编译器向量化
+template <typename T>
+inline T pixelFromFloat(float v)
+{
+    if constexpr (std::is_integral_v<T>)
+    {
+        constexpr float lo = std::numeric_limits<T>::min();
+        constexpr float hi = std::numeric_limits<T>::max();
+        return static_cast<T>(std::clamp(std::floor(v + 0.5f), lo, hi));
+    }
+    else
+    {
+        return static_cast<T>(v);
+    }
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+// point_ops.hpp
+// 8 位点运算流水线：把一串逐像素映射（gamma、均衡化表、阈值分段、位平面、反色……）合成一张 256 项查找表，
+// 再对图像只做一遍查表
+//
+// 点运算 f(v) 只依赖像素值本身，任意多个 f 的复合仍然只是一张 256 项的表：
+//   - 合成：每加入一个运算，对当前表的 256 个值各算一次（与图像大小无关）
+//   - 应用：AVX2 下用 vpshufb 做 256 项查表。vpshufb 只能查 16 项，按高半字节分成 16 张子表，
+//     第 h 张子表的下标取 v - 16h 并饱和加 0x70：只有高半字节等于 h 的字节最高位为 0，其余字节查表结果为 0，
+//     各次查表的结果按位或起来就是完整的查表结果。去掉 v 的最高位后子表 h 与 h+8 共用下标，
+//     最后按 v 的最高位 vpblendvb 二选一，每 32 字节 8 次下标计算 + 16 次 vpshufb
+//   - 按行块多线程；连续存储的图像当作一行处理
+// 五个运算的链与单个运算的代价相同，都是一遍读 + 一遍写。
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX2__)
+/*
+ * @struct LutAvx2
+ * @brief  256 项查找表拆成的 16 张 16 项子表（每张在两个 128 位通道中各存一份）
+ */
+struct LutAvx2
+{
+    __m256i sub[16];
+
+    explicit LutAvx2(const uint8_t *lut)
+    {
+        for (int h = 0; h < 16; ++h)
+        {
+            __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lut + 16 * h));
+            sub[h] = _mm256_broadcastsi128_si256(t);
+        }
+    }
+
+    // 两组 32 字节同时查表（两条独立的依赖链，填满 vpshufb 的流水线）
+    void lookup2(__m256i v0, __m256i v1, __m256i &r0, __m256i &r1) const
+    {
+        const __m256i bias = _mm256_set1_epi8(0x70);
+        const __m256i step = _mm256_set1_epi8(16);
+        const __m256i low7 = _mm256_set1_epi8(0x7f);
+        // 去掉最高位后同一个下标同时查子表 h（v < 128）和 h+8（v >= 128），最后按 v 的最高位选择
+        __m256i a0 = _mm256_and_si256(v0, low7), a1 = _mm256_and_si256(v1, low7);
+        __m256i lo0 = _mm256_setzero_si256(), hi0 = lo0, lo1 = lo0, hi1 = lo0;
+        for (int h = 0; h < 8; ++h)
+        {
+            // a 的高半字节为 h 时 a+0x70 落在 [0x70, 0x7f]，否则饱和到 >= 0x80，vpshufb 输出 0
+            const __m256i i0 = _mm256_adds_epu8(a0, bias), i1 = _mm256_adds_epu8(a1, bias);
+            lo0 = _mm256_or_si256(lo0, _mm256_shuffle_epi8(sub[h], i0));
+            hi0 = _mm256_or_si256(hi0, _mm256_shuffle_epi8(sub[h + 8], i0));
+            lo1 = _mm256_or_si256(lo1, _mm256_shuffle_epi8(sub[h], i1));
+            hi1 = _mm256_or_si256(hi1, _mm256_shuffle_epi8(sub[h + 8], i1));
+            a0 = _mm256_sub_epi8(a0, step);
+            a1 = _mm256_sub_epi8(a1, step);
+        }
+        r0 = _mm256_blendv_epi8(lo0, hi0, v0);
+        r1 = _mm256_blendv_epi8(lo1, hi1, v1);
+    }
+};
+#endif
+
+/*
+ * @function lutApplyRow
+ * @brief  对连续的 n 个字节查表
+ */
+inline void lutApplyRow(const uint8_t *src, uint8_t *dst, size_t n, const uint8_t *lut)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    if (n >= 64)
+    {
+        const LutAvx2 t(lut);
+        for (; i + 64 <= n; i += 64)
+        {
+            __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 32));
+            __m256i r0, r1;
+            t.lookup2(v0, v1, r0, r1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), r0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 32), r1);
+        }
+    }
+#endif
+    for (; i < n; ++i)
+        dst[i] = lut[src[i]];
+}
+
+/*
+ * @function myApplyLut
+ * @brief  8 位图像逐字节查表（对应 cv::LUT，多通道时所有通道共用一张表）
+ * @param  src 输入图像（CV_8U，任意通道数）
+ * @param  lut 256 项查找表
+ * @param  dst 输出图像，可以与 src 相同（原地）
+ */
+inline void myApplyLut(const cv::Mat &src, const uint8_t *lut, cv::Mat &dst)
+{
+    CV_Assert(src.depth() == CV_8U && lut != nullptr);
+    if (dst.data != src.data)
+        dst.create(src.rows, src.cols, src.type());
+
+    const size_t row_bytes = static_cast<size_t>(src.cols) * src.elemSize();
+    if (src.isContinuous() && dst.isContinuous())
+    {
+        // 连续存储：按 64 KB 的块分给线程，块边界对齐到 64 字节
+        constexpr size_t kChunk = 1 << 16;
+        const size_t total = row_bytes * src.rows;
+        const int chunks = static_cast<int>((total + kChunk - 1) / kChunk);
+        const uint8_t *s = src.ptr<uint8_t>(0);
+        uint8_t *d = dst.ptr<uint8_t>(0);
+        cv::parallel_for_(cv::Range(0, chunks), [&](const cv::Range &r)
+                          {
+            const size_t b = r.start * kChunk, e = std::min(total, r.end * kChunk);
+            lutApplyRow(s + b, d + b, e - b, lut); });
+        return;
+    }
+
+    cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+            lutApplyRow(src.ptr<uint8_t>(y), dst.ptr<uint8_t>(y), row_bytes, lut); });
+}
+
+inline cv::Mat myApplyLut(const cv::Mat &src, const uint8_t *lut)
+{
+    cv::Mat dst;
+    myApplyLut(src, lut, dst);
+    return dst;
+}
+
+/*
+ * @class PointOpChain
+ * @brief  点运算链：按调用顺序复合，table() 为合成后的 256 项表，apply() 一遍查表
+ * @note   例：PointOpChain().gamma(0.5).lut(eq).invert().apply(img)
+ */
+class PointOpChain
+{
+public:
+    PointOpChain()
+    {
+        for (int v = 0; v < 256; ++v)
+            table_[v] = static_cast<uint8_t>(v);
+    }
+
+    // 任意映射 f: uint8_t -> uint8_t
+    template <typename F>
+    PointOpChain &map(F &&f)
+    {
+        for (auto &t : table_)
+            t = static_cast<uint8_t>(f(t));
+        return *this;
+    }
+
+    // 查找表（如直方图均衡化的表）
+    PointOpChain &lut(const uint8_t *t)
+    {
+        return map([t](uint8_t v)
+                   { return t[v]; });
+    }
+
+    // 幂律（gamma）变换：s = round(255 * (r/255)^gamma)
+    PointOpChain &gamma(double g)
+    {
+        return map([g](uint8_t v)
+                   { return std::clamp(static_cast<int>(std::round(std::pow(v / 255.0, g) * 255.0)), 0, 255); });
+    }
+
+    /*
+     * @function bands
+     * @brief  阈值分段：v <= thresholds[0] 映射为 levels[0]，thresholds[i-1] < v <= thresholds[i] 映射为 levels[i]，
+     *         大于最后一个阈值映射为 levels.back()
+     * @param  thresholds 递增的阈值（K 个）
+     * @param  levels     每段的输出灰度（K+1 个）
+     */
+    PointOpChain &bands(const std::vector<int> &thresholds, const std::vector<uint8_t> &levels)
+    {
+        CV_Assert(levels.size() == thresholds.size() + 1);
+        CV_Assert(std::is_sorted(thresholds.begin(), thresholds.end()));
+        return map([&](uint8_t v)
+                   { return levels[std::lower_bound(thresholds.begin(), thresholds.end(), static_cast<int>(v)) -
+                                   thresholds.begin()]; });
+    }
+
+    // 位平面：第 bit 位为 1 时输出 255，否则 0
+    PointOpChain &bitPlane(int bit)
+    {
+        CV_Assert(bit >= 0 && bit < 8);
+        return map([bit](uint8_t v)
+                   { return ((v >> bit) & 1) ? 255 : 0; });
+    }
+
+    // 反色：s = 255 - r
+    PointOpChain &invert()
+    {
+        return map([](uint8_t v)
+                   { return 255 - v; });
+    }
+
+    const std::array<uint8_t, 256> &table() const { return table_; }
+
+    void apply(const cv::Mat &src, cv::Mat &dst) const { myApplyLut(src, table_.data(), dst); }
+    cv::Mat apply(const cv::Mat &src) const { return myApplyLut(src, table_.data()); }
+
+private:
+    std::array<uint8_t, 256> table_;
+};
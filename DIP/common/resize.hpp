@@ -0,0 +1,260 @@
+#pragma once
+
+// resize.hpp
+// 可分离、系数表驱动的缩放：最近邻 / 双线性 / 双三次 / Lanczos-3 / 区域平均
+//
+// 每个轴只在开始时算一次系数表（每个输出位置的 K 个源下标 + K 个权重），之后：
+//   1. 水平方向：对需要的源行做一维重采样，结果放进 K 行的环形缓冲（float）
+//   2. 垂直方向：对环形缓冲中的 K 行按行权重加权求和，写出一行
+// 工作集只有 K 行输出宽度的 float，能留在 L1/L2 中；源行按需水平重采样，每行最多算一次（同一条带内）。
+// 越界的源下标在建表时截断到边界（复制边界像素）。
+// 内核按 <像素类型, 通道数> 模板化，由 cv::Mat::type() 在运行时分发。
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "pixel.hpp"
+
+enum class ResizeMode
+{
+    Nearest,
+    Bilinear,
+    Bicubic,
+    Lanczos3,
+    Area, // 缩小时按覆盖面积加权平均（抗混叠）；放大时退化为双线性
+};
+
+/*
+ * @struct ResizeAxisTable
+ * @brief  一个轴上的系数表：第 i 个输出位置使用 idx[i*ksize + t] 与 w[i*ksize + t]
+ */
+struct ResizeAxisTable
+{
+    int ksize = 0;
+    std::vector<int> idx;
+    std::vector<float> w;
+};
+
+// 双三次卷积核，A = -0.75 与 OpenCV 的 INTER_CUBIC 一致
+inline double resizeCubicWeight(double t)
+{
+    constexpr double A = -0.75;
+    t = std::abs(t);
+    if (t < 1.0)
+        return ((A + 2) * t - (A + 3)) * t * t + 1;
+    if (t < 2.0)
+        return ((A * t - 5 * A) * t + 8 * A) * t - 4 * A;
+    return 0.0;
+}
+
+inline double resizeLanczos3Weight(double t)
+{
+    t = std::abs(t);
+    if (t < 1e-12)
+        return 1.0;
+    if (t >= 3.0)
+        return 0.0;
+    double pt = CV_PI * t;
+    return 3.0 * std::sin(pt) * std::sin(pt / 3.0) / (pt * pt);
+}
+
+/*
+ * @function myBuildResizeTable
+ * @brief  为一个轴构建系数表
+ * @param  src_len 源长度
+ * @param  dst_len 目标长度
+ * @param  mode    插值方式
+ * @return         系数表（权重已归一化，下标已截断到 [0, src_len-1]）
+ */
+inline ResizeAxisTable myBuildResizeTable(int src_len, int dst_len, ResizeMode mode)
+{
+    CV_Assert(src_len > 0 && dst_len > 0);
+
+    const double scale = static_cast<double>(src_len) / dst_len;
+    if (mode == ResizeMode::Area && scale <= 1.0)
+        mode = ResizeMode::Bilinear;
+
+    ResizeAxisTable tab;
+    // Lanczos 缩小时把核拉宽 scale 倍，起到低通抗混叠的作用
+    const double lanczos_scale = std::max(1.0, scale);
+    switch (mode)
+    {
+    case ResizeMode::Nearest:
+        tab.ksize = 1;
+        break;
+    case ResizeMode::Bilinear:
+        tab.ksize = 2;
+        break;
+    case ResizeMode::Bicubic:
+        tab.ksize = 4;
+        break;
+    case ResizeMode::Lanczos3:
+        tab.ksize = 2 * static_cast<int>(std::ceil(3.0 * lanczos_scale)) + 1;
+        break;
+    case ResizeMode::Area:
+        tab.ksize = static_cast<int>(std::ceil(scale)) + 1;
+        break;
+    }
+
+    const int K = tab.ksize;
+    tab.idx.assign(static_cast<size_t>(dst_len) * K, 0);
+    tab.w.assign(static_cast<size_t>(dst_len) * K, 0.0f);
+
+    std::vector<double> w(K);
+    for (int i = 0; i < dst_len; ++i)
+    {
+        // 像素中心对齐的源坐标
+        const double c = (i + 0.5) * scale - 0.5;
+        int start = 0;
+        std::fill(w.begin(), w.end(), 0.0);
+
+        switch (mode)
+        {
+        case ResizeMode::Nearest:
+            // 与原 nearestNeighborResize 的取整方式保持一致
+            start = static_cast<int>(std::round(i * scale));
+            w[0] = 1.0;
+            break;
+        case ResizeMode::Bilinear:
+        {
+            start = static_cast<int>(std::floor(c));
+            double d = c - start;
+            w[0] = 1.0 - d;
+            w[1] = d;
+            break;
+        }
+        case ResizeMode::Bicubic:
+        {
+            int i0 = static_cast<int>(std::floor(c));
+            double d = c - i0;
+            start = i0 - 1;
+            for (int t = 0; t < 4; ++t)
+                w[t] = resizeCubicWeight(d + 1 - t);
+            break;
+        }
+        case ResizeMode::Lanczos3:
+        {
+            const double support = 3.0 * lanczos_scale;
+            start = static_cast<int>(std::floor(c - support)) + 1;
+            for (int t = 0; t < K; ++t)
+                w[t] = resizeLanczos3Weight((start + t - c) / lanczos_scale);
+            break;
+        }
+        case ResizeMode::Area:
+        {
+            // 第 i 个输出像素覆盖源区间 [i*scale, (i+1)*scale)
+            const double a = i * scale, b = (i + 1) * scale;
+            start = static_cast<int>(std::floor(a));
+            for (int t = 0; t < K; ++t)
+            {
+                double lo = std::max(a, static_cast<double>(start + t));
+                double hi = std::min(b, static_cast<double>(start + t + 1));
+                w[t] = std::max(0.0, hi - lo);
+            }
+            break;
+        }
+        }
+
+        double sum = 0.0;
+        for (int t = 0; t < K; ++t)
+            sum += w[t];
+        for (int t = 0; t < K; ++t)
+        {
+            tab.idx[i * K + t] = std::clamp(start + t, 0, src_len - 1);
+            tab.w[i * K + t] = static_cast<float>(w[t] / sum);
+        }
+    }
+    return tab;
+}
+
+/*
+ * @function resizeHorizontalRow
+ * @brief  水平方向一维重采样一行（交错存放的 CN 个通道）
+ */
+template <typename T, int CN>
+inline void resizeHorizontalRow(const T *src, const ResizeAxisTable &tx, float *out, int dst_w)
+{
+    const int K = tx.ksize;
+    const int *idx = tx.idx.data();
+    const float *w = tx.w.data();
+    for (int x = 0; x < dst_w; ++x, idx += K, w += K, out += CN)
+    {
+        float acc[CN] = {};
+        for (int t = 0; t < K; ++t)
+        {
+            const T *p = src + idx[t] * CN;
+            for (int c = 0; c < CN; ++c)
+                acc[c] += w[t] * p[c];
+        }
+        for (int c = 0; c < CN; ++c)
+            out[c] = acc[c];
+    }
+}
+
+/*
+ * @function mySeparableResize
+ * @brief  可分离缩放（u8/u16/f32/f64，1~4 通道）
+ * @param  src   输入图像
+ * @param  dsize 输出尺寸
+ * @param  mode  插值方式
+ * @return       缩放后的图像，类型与 src 相同
+ * @note 先水平后垂直；按输出行带多线程，每个条带有自己的 K 行环形缓冲
+ */
+inline cv::Mat mySeparableResize(const cv::Mat &src, cv::Size dsize, ResizeMode mode)
+{
+    CV_Assert(!src.empty() && dsize.width > 0 && dsize.height > 0);
+
+    const ResizeAxisTable tx = myBuildResizeTable(src.cols, dsize.width, mode);
+    const ResizeAxisTable ty = myBuildResizeTable(src.rows, dsize.height, mode);
+    cv::Mat dst(dsize, src.type());
+
+    myDispatchPixelType(src.type(), [&]<typename T, int CN>()
+                        { cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range &range)
+                                            {
+        // 一行按标量个数计：W 个像素 * CN 个通道
+        const int W = dst.cols, WN = dst.cols * CN, K = ty.ksize;
+        // 一个输出行需要的 K 个源行是连续的（截断后可能重复），按 源行号 % K 放入环形缓冲不会互相覆盖
+        std::vector<float> ring(static_cast<size_t>(K) * WN);
+        std::vector<int> ring_src(K, -1);
+        std::vector<const float *> rows(K);
+        std::vector<float> acc(WN);
+
+        for (int y = range.start; y < range.end; ++y)
+        {
+            const int *iy = ty.idx.data() + y * K;
+            const float *wy = ty.w.data() + y * K;
+
+            for (int t = 0; t < K; ++t)
+            {
+                int slot = iy[t] % K;
+                float *buf = ring.data() + static_cast<size_t>(slot) * WN;
+                if (ring_src[slot] != iy[t])
+                {
+                    resizeHorizontalRow<T, CN>(src.ptr<T>(iy[t]), tx, buf, W);
+                    ring_src[slot] = iy[t];
+                }
+                rows[t] = buf;
+            }
+
+            // 垂直方向：连续内存上的乘加，编译器可自动向量化
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            for (int t = 0; t < K; ++t)
+            {
+                const float wt = wy[t];
+                const float *r = rows[t];
+                if (wt == 0.0f)
+                    continue;
+                for (int x = 0; x < WN; ++x)
+                    acc[x] += wt * r[x];
+            }
+
+            T *out = dst.ptr<T>(y);
+            for (int x = 0; x < WN; ++x)
+                out[x] = pixelFromFloat<T>(acc[x]);
+        } }); });
+
+    return dst;
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+// sharpen.hpp
+// 锐化：拉普拉斯锐化与高提升（unsharp mask）滤波，都是一遍读入 8 位图像、同时写出全部结果
+//
+// 拉普拉斯锐化（myLaplacianSharpen）：
+//   - 3x3 的 -4 / -8 拉普拉斯核系数都是小整数，8 位输入下 |lap| <= 2040，整数 k 时 v - k*lap 也在 int16 内，
+//     AVX2 下 16 个像素一组在 int16 通道中累加：上下左右（和四个对角）相加，再减去 4（8）倍中心
+//   - 截断到 [0, 255] 与转回 8 位合成一条 vpackuswb（有符号 16 位饱和到无符号 8 位）
+//   - 边界与 filter2D 默认的 BORDER_REFLECT_101 相同：上下边缘通过行指针映射，左右两端的像素走标量路径
+//   - k 不是整数（或太大以致 int16 溢出）时逐像素用 double 计算，仍是一遍完成
+// 原实现转 CV_64F、filter2D、相减、两次 min/max、两次 convertTo，约 8 遍 8 字节/像素的整图读写
+//
+// 高提升滤波（myHighBoost）：smooth = G * src，mask = src - smooth，boost = src + k * mask
+//   - 按行带流水：每个线程只保留 ksize 行水平卷积结果的环形缓冲，新进一行做一次水平卷积，
+//     竖直卷积得到一行 smooth 后立即在寄存器里算出 mask 与 boost，三个结果各自截断取整写出
+//   - 输出可以是预先分配好的 ROI（例如拼接画布的一块），create 不会重新分配，结果直接写进画布
+//   - 用 FIR 高斯（与 gaussian.hpp 相同的核与 BORDER_REFLECT_101）：递归高斯的竖直反因果一遍要等整列算完，无法按行带流水
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "conv.hpp"
+#include "gaussian.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * @function myLaplacianSharpen
+ * @brief  拉普拉斯锐化：laplace = clip(lap)，enhanced = clip(src - k * lap)
+ * @param  src      CV_8UC1
+ * @param  use8     true 为 -8 核（含对角），false 为 -4 核
+ * @param  k        增强系数
+ * @param  laplace  输出 CV_8UC1
+ * @param  enhanced 输出 CV_8UC1
+ */
+inline void myLaplacianSharpen(const cv::Mat &src, bool use8, double k, cv::Mat &laplace, cv::Mat &enhanced)
+{
+    CV_Assert(src.type() == CV_8UC1);
+    laplace.create(src.size(), CV_8UC1);
+    enhanced.create(src.size(), CV_8UC1);
+    const int rows = src.rows, cols = src.cols;
+    // BORDER_REFLECT_101：-1 -> 1，n -> n-2（只有 1 行/列时就是自身）
+    auto reflect = [](int p, int n)
+    { return n == 1 ? 0 : (p < 0 ? 1 : (p >= n ? n - 2 : p)); };
+
+    // |lap| <= 2040，|k| <= 15 时 255 + 15*2040 < 32767
+    const int ki = static_cast<int>(std::lround(k));
+    const bool int_path = ki == k && std::abs(ki) <= 15;
+
+    auto scalar_pixel = [&](const uint8_t *up, const uint8_t *mid, const uint8_t *down, int x, uint8_t *lap_out, uint8_t *enh_out)
+    {
+        const int l = reflect(x - 1, cols), r = reflect(x + 1, cols);
+        int lap = up[x] + down[x] + mid[l] + mid[r] - 4 * mid[x];
+        if (use8)
+            lap += up[l] + up[r] + down[l] + down[r] - 4 * mid[x];
+        lap_out[x] = static_cast<uint8_t>(std::clamp(lap, 0, 255));
+        if (int_path)
+            enh_out[x] = static_cast<uint8_t>(std::clamp(mid[x] - ki * lap, 0, 255));
+        else
+            enh_out[x] = static_cast<uint8_t>(std::clamp(std::nearbyint(mid[x] - k * lap), 0.0, 255.0)); // 与 convertTo 一样就近取偶
+    };
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &range)
+                      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+            const uint8_t *up = src.ptr<uint8_t>(reflect(y - 1, rows));
+            const uint8_t *mid = src.ptr<uint8_t>(y);
+            const uint8_t *down = src.ptr<uint8_t>(reflect(y + 1, rows));
+            uint8_t *lo = laplace.ptr<uint8_t>(y);
+            uint8_t *eo = enhanced.ptr<uint8_t>(y);
+
+            scalar_pixel(up, mid, down, 0, lo, eo);
+            int x = 1;
+#if defined(__AVX2__)
+            if (int_path)
+            {
+                const __m256i kv = _mm256_set1_epi16(static_cast<int16_t>(ki));
+                auto load16 = [](const uint8_t *p)
+                { return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))); };
+                // 16 个像素的拉普拉斯值与增强值（int16）
+                auto lap16 = [&](int x0, __m256i &lap, __m256i &enh)
+                {
+                    const __m256i c = load16(mid + x0);
+                    __m256i s = _mm256_add_epi16(_mm256_add_epi16(load16(up + x0), load16(down + x0)),
+                                                 _mm256_add_epi16(load16(mid + x0 - 1), load16(mid + x0 + 1)));
+                    __m256i c4 = _mm256_slli_epi16(c, 2);
+                    if (use8)
+                    {
+                        s = _mm256_add_epi16(s, _mm256_add_epi16(_mm256_add_epi16(load16(up + x0 - 1), load16(up + x0 + 1)),
+                                                                 _mm256_add_epi16(load16(down + x0 - 1), load16(down + x0 + 1))));
+                        c4 = _mm256_slli_epi16(c, 3);
+                    }
+                    lap = _mm256_sub_epi16(s, c4);
+                    enh = _mm256_sub_epi16(c, _mm256_mullo_epi16(kv, lap));
+                };
+                // 每次 32 个像素，最右一列留给标量（需要读 x+1）
+                for (; x + 33 <= cols; x += 32)
+                {
+                    __m256i l0, e0, l1, e1;
+                    lap16(x, l0, e0);
+                    lap16(x + 16, l1, e1);
+                    // packus 饱和到 [0, 255] 即截断；按 128 位通道交错，permute 恢复顺序
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lo + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(l0, l1), 0xD8));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(eo + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(e0, e1), 0xD8));
+                }
+            }
+#endif
+            for (; x < cols; ++x)
+                scalar_pixel(up, mid, down, x, lo, eo);
+        } });
+}
+
+/*
+ * @function myHighBoost
+ * @brief  高斯高提升滤波：smooth = clip(G * src)，mask = clip(src - G * src)，boost = clip(src + k * (src - G * src))
+ * @param  src    CV_8UC1
+ * @param  k      提升系数（k = 1 为 unsharp mask）
+ * @param  ksize  高斯核尺寸（奇数）；0 表示取 2*ceil(3 sigma)+1
+ * @param  sigma  高斯标准差（> 0）
+ * @param  smooth 输出 CV_8UC1；已是同尺寸 CV_8UC1（可以是 ROI）时直接写入
+ * @param  mask   同上
+ * @param  boost  同上
+ */
+inline void myHighBoost(const cv::Mat &src, float k, int ksize, double sigma, cv::Mat &smooth, cv::Mat &mask, cv::Mat &boost)
+{
+    CV_Assert(src.type() == CV_8UC1 && sigma > 0);
+    if (ksize <= 0)
+        ksize = 2 * static_cast<int>(std::ceil(3 * sigma)) + 1;
+    const std::vector<float> kernel = myGaussianKernel1D(ksize, sigma);
+    smooth.create(src.size(), CV_8UC1);
+    mask.create(src.size(), CV_8UC1);
+    boost.create(src.size(), CV_8UC1);
+
+    const int r = ksize / 2, rows = src.rows, cols = src.cols;
+    // 每个行带开头要先补齐 ksize - 1 行水平卷积，行带取核高的数倍以摊薄这部分代价
+    const int band = std::max(32, 4 * ksize);
+    const int bands = (rows + band - 1) / band;
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &range)
+                      {
+        std::vector<float> padded(cols + ksize - 1);
+        std::vector<float> ring(static_cast<size_t>(ksize) * cols); // 第 i 行水平卷积结果在 i mod ksize 处
+        std::vector<float> out(cols);
+        std::vector<const float *> taps(ksize);
+        auto slot = [&](int i)
+        { return &ring[static_cast<size_t>((i % ksize + ksize) % ksize) * cols]; };
+        // 第 i 行（按 BORDER_REFLECT_101 映射）转 float、左右补镜像后水平卷积
+        auto horizontal = [&](int i)
+        {
+            const uint8_t *s = src.ptr<uint8_t>(gaussReflect101(i, rows));
+            for (int x = 0; x < cols; ++x)
+                padded[r + x] = s[x];
+            for (int j = 1; j <= r; ++j)
+            {
+                padded[r - j] = s[gaussReflect101(-j, cols)];
+                padded[r + cols - 1 + j] = s[gaussReflect101(cols - 1 + j, cols)];
+            }
+            const float *p = padded.data();
+            convRowF<false>(&p, kernel.data(), 1, ksize, slot(i), cols);
+        };
+
+        for (int b = range.start; b < range.end; ++b)
+        {
+            const int y0 = b * band, y1 = std::min(rows, y0 + band);
+            for (int i = y0 - r; i < y0 + r; ++i)
+                horizontal(i);
+            for (int y = y0; y < y1; ++y)
+            {
+                horizontal(y + r);
+                for (int i = 0; i < ksize; ++i)
+                    taps[i] = slot(y - r + i);
+                convRowF<false>(taps.data(), kernel.data(), ksize, 1, out.data(), cols);
+
+                const uint8_t *s = src.ptr<uint8_t>(y);
+                uint8_t *so = smooth.ptr<uint8_t>(y), *mo = mask.ptr<uint8_t>(y), *bo = boost.ptr<uint8_t>(y);
+                int x = 0;
+#if defined(__AVX2__)
+                const __m256 kv = _mm256_set1_ps(k), lo = _mm256_setzero_ps(), hi = _mm256_set1_ps(255.0f);
+                for (; x + 8 <= cols; x += 8)
+                {
+                    const __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + x))));
+                    const __m256 g = _mm256_loadu_ps(&out[x]);
+                    const __m256 m = _mm256_sub_ps(v, g);
+                    // smooth 与 mask 在 [-255, 255] 内，convStore8 饱和即截断；boost 随 k 增大，先在 float 中截断
+                    const __m256 bst = _mm256_min_ps(_mm256_max_ps(convMulAdd(kv, m, v), lo), hi);
+                    convStore8(so + x, g);
+                    convStore8(mo + x, m);
+                    convStore8(bo + x, bst);
+                }
+#endif
+                for (; x < cols; ++x)
+                {
+                    const float m = s[x] - out[x];
+                    so[x] = cv::saturate_cast<uchar>(out[x]);
+                    mo[x] = cv::saturate_cast<uchar>(m);
+                    bo[x] = cv::saturate_cast<uchar>(std::clamp(s[x] + k * m, 0.0f, 255.0f));
+                }
+            }
+        } });
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+// shear_rotate.hpp
+// Paeth 三次剪切旋转：R = Sx(a) * Sy(b) * Sx(a)，a = tan(θ/2)，b = -sin(θ)
+//
+// 与逐像素的二维双线性 gather 不同，每次剪切都是一维操作：
+//   - x 剪切：输出的一行来自源图像的同一行整体平移一个小数偏移，整行共用同一对插值权重，连续读写
+//   - y 剪切：每一列整体平移，偏移只随列变化；同一行中偏移的整数部分相同的一段列从相邻两行连续读取
+// 因此三趟都按行流式读写，内层循环是连续内存上的两抽头混合，编译器可以直接向量化；每一趟按行带多线程。
+// |θ| > 90° 时 tan(θ/2) 过大，拆成两次 θ/2 旋转。
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "pixel.hpp"
+
+/*
+ * @struct ShearCanvas
+ * @brief  一趟剪切的输入/输出画布：origin 是相对坐标 (0, 0) 在该画布上的像素坐标
+ */
+struct ShearCanvas
+{
+    cv::Mat img;
+    cv::Point2d origin;
+};
+
+// 两抽头混合：u8 使用 8 位整数权重（w8 取值 0..256），其余类型使用浮点权重
+template <typename T>
+inline T shearLerp(T a, T b, int w8, float wf)
+{
+    if constexpr (std::is_same_v<T, uchar>)
+        return static_cast<uchar>((a * (256 - w8) + b * w8 + 128) >> 8);
+    else
+        return pixelFromFloat<T>(a + (static_cast<float>(b) - static_cast<float>(a)) * wf);
+}
+
+inline int shearWeight8(double frac) { return static_cast<int>(std::lround(frac * 256.0)); }
+
+/*
+ * @function shearPassX
+ * @brief  x 剪切一趟：输出相对坐标 (xr, yr) 取自输入相对坐标 (xr - a*yr, yr)
+ * @note   要求 in.origin.y 与 out.origin.y 相差整数，使输出行与输入行一一对应
+ */
+template <typename T, int CN>
+inline void shearPassX(const ShearCanvas &in, ShearCanvas &out, double a)
+{
+    const int dy = static_cast<int>(std::lround(in.origin.y - out.origin.y));
+    const int Wi = in.img.cols, Wo = out.img.cols;
+
+    cv::parallel_for_(cv::Range(0, out.img.rows), [&](const cv::Range &range)
+                      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+            T *o = out.img.ptr<T>(y);
+            const int sy = y + dy;
+            if (sy < 0 || sy >= in.img.rows)
+            {
+                std::fill(o, o + Wo * CN, T(0));
+                continue;
+            }
+            const T *s = in.img.ptr<T>(sy);
+
+            // 源 x = x + shift，shift 对整行是常数
+            const double shift = in.origin.x - out.origin.x - a * (y - out.origin.y);
+            int i0 = static_cast<int>(std::floor(shift));
+            double frac = shift - i0;
+            int w8 = shearWeight8(frac);
+            if (w8 == 256)
+            {
+                ++i0;
+                w8 = 0;
+                frac = 0.0;
+            }
+            const float wf = static_cast<float>(frac);
+
+            // 两个抽头都在源行内的输出区间 [lo, hi)，区间内是纯连续的两抽头混合
+            const int lo = std::clamp(-i0, 0, Wo);
+            const int hi = std::clamp(Wi - 1 - i0, lo, Wo);
+
+            auto sample = [&](int sx, int c) -> T
+            { return (sx >= 0 && sx < Wi) ? s[sx * CN + c] : T(0); };
+            auto edge = [&](int x)
+            {
+                for (int c = 0; c < CN; ++c)
+                    o[x * CN + c] = shearLerp<T>(sample(x + i0, c), sample(x + i0 + 1, c), w8, wf);
+            };
+
+            for (int x = 0; x < lo; ++x)
+                edge(x);
+
+            const T *pa = s + (lo + i0) * CN;
+            const T *pb = pa + CN;
+            T *po = o + lo * CN;
+            for (int k = 0, n = (hi - lo) * CN; k < n; ++k)
+                po[k] = shearLerp<T>(pa[k], pb[k], w8, wf);
+
+            for (int x = hi; x < Wo; ++x)
+                edge(x);
+        } });
+}
+
+/*
+ * @function shearPassY
+ * @brief  y 剪切一趟：输出相对坐标 (xr, yr) 取自输入相对坐标 (xr, yr - b*xr)
+ * @note   要求 in.origin.x 与 out.origin.x 相差整数，使输出列与输入列一一对应；
+ *         每列的整数偏移与权重只算一次，偏移相同的一段列从两行输入中连续读取
+ */
+template <typename T, int CN>
+inline void shearPassY(const ShearCanvas &in, ShearCanvas &out, double b)
+{
+    const int dx = static_cast<int>(std::lround(in.origin.x - out.origin.x));
+    const int Wo = out.img.cols, Hi = in.img.rows, Wi = in.img.cols;
+
+    // 每列：整数行偏移 off[x]，权重按通道展开，便于连续内存上的混合
+    std::vector<int> off(Wo);
+    std::vector<int> w8(static_cast<size_t>(Wo) * CN);
+    std::vector<float> wf(static_cast<size_t>(Wo) * CN);
+    for (int x = 0; x < Wo; ++x)
+    {
+        double shift = in.origin.y - out.origin.y - b * (x - out.origin.x);
+        int i0 = static_cast<int>(std::floor(shift));
+        double frac = shift - i0;
+        int w = shearWeight8(frac);
+        if (w == 256)
+        {
+            ++i0;
+            w = 0;
+            frac = 0.0;
+        }
+        off[x] = i0;
+        for (int c = 0; c < CN; ++c)
+        {
+            w8[x * CN + c] = w;
+            wf[x * CN + c] = static_cast<float>(frac);
+        }
+    }
+
+    // 输出列与输入列一一对应的区间 [xlo, xhi)，区间外整列为 0
+    const int xlo = std::clamp(-dx, 0, Wo);
+    const int xhi = std::clamp(Wi - dx, xlo, Wo);
+
+    // 按整数偏移把 [xlo, xhi) 切成若干段
+    std::vector<int> run_begin;
+    for (int x = xlo; x < xhi; ++x)
+        if (x == xlo || off[x] != off[x - 1])
+            run_begin.push_back(x);
+    run_begin.push_back(xhi);
+
+    cv::parallel_for_(cv::Range(0, out.img.rows), [&](const cv::Range &range)
+                      {
+        for (int y = range.start; y < range.end; ++y)
+        {
+            T *o = out.img.ptr<T>(y);
+            std::fill(o, o + xlo * CN, T(0));
+            std::fill(o + xhi * CN, o + Wo * CN, T(0));
+
+            for (size_t r = 0; r + 1 < run_begin.size(); ++r)
+            {
+                const int x0 = run_begin[r], x1 = run_begin[r + 1];
+                const int ya = y + off[x0], yb = ya + 1;
+                const bool ha = ya >= 0 && ya < Hi, hb = yb >= 0 && yb < Hi;
+                T *po = o + x0 * CN;
+                const int n = (x1 - x0) * CN;
+                if (!ha && !hb)
+                {
+                    std::fill(po, po + n, T(0));
+                    continue;
+                }
+
+                const T *pa = ha ? in.img.ptr<T>(ya) + (x0 + dx) * CN : nullptr;
+                const T *pb = hb ? in.img.ptr<T>(yb) + (x0 + dx) * CN : nullptr;
+                const int *pw8 = w8.data() + x0 * CN;
+                const float *pwf = wf.data() + x0 * CN;
+                if (ha && hb)
+                {
+                    for (int k = 0; k < n; ++k)
+                        po[k] = shearLerp<T>(pa[k], pb[k], pw8[k], pwf[k]);
+                }
+                else
+                {
+                    for (int k = 0; k < n; ++k)
+                        po[k] = shearLerp<T>(ha ? pa[k] : T(0), hb ? pb[k] : T(0), pw8[k], pwf[k]);
+                }
+            }
+        } });
+}
+
+/*
+ * @function shearBounds
+ * @brief  相对坐标矩形 [x0, x1] x [y0, y1] 经线性变换 [m00 m01; m10 m11] 后的包围盒
+ */
+inline cv::Rect2d shearBounds(const cv::Rect2d &r, double m00, double m01, double m10, double m11)
+{
+    double xs[4] = {r.x, r.x + r.width, r.x, r.x + r.width};
+    double ys[4] = {r.y, r.y, r.y + r.height, r.y + r.height};
+    double min_x = 1e300, min_y = 1e300, max_x = -1e300, max_y = -1e300;
+    for (int i = 0; i < 4; ++i)
+    {
+        double px = m00 * xs[i] + m01 * ys[i], py = m10 * xs[i] + m11 * ys[i];
+        min_x = std::min(min_x, px);
+        max_x = std::max(max_x, px);
+        min_y = std::min(min_y, py);
+        max_y = std::max(max_y, py);
+    }
+    return cv::Rect2d(min_x, min_y, max_x - min_x, max_y - min_y);
+}
+
+/*
+ * @function shearIntersect
+ * @brief  两个相对坐标矩形的交集（为空时宽或高不大于 0）
+ */
+inline cv::Rect2d shearIntersect(const cv::Rect2d &r, const cv::Rect2d &s)
+{
+    double x0 = std::max(r.x, s.x), y0 = std::max(r.y, s.y);
+    double x1 = std::min(r.x + r.width, s.x + s.width), y1 = std::min(r.y + r.height, s.y + s.height);
+    return cv::Rect2d(x0, y0, x1 - x0, y1 - y0);
+}
+
+/*
+ * @function shearMakeCanvas
+ * @brief  覆盖相对坐标范围 r 的中间画布
+ * @param  r     需要覆盖的相对坐标范围
+ * @param  phase 原点与 phase 在两个轴上都只差整数，用来保持与上一趟/下一趟的行列对齐
+ * @param  type  图像类型
+ * @note   四周各留 1 像素，保证下一趟的两个插值抽头都落在画布内
+ */
+inline ShearCanvas shearMakeCanvas(const cv::Rect2d &r, cv::Point2d phase, int type)
+{
+    ShearCanvas c;
+    c.origin.x = phase.x + std::ceil(-r.x - phase.x) + 1;
+    c.origin.y = phase.y + std::ceil(-r.y - phase.y) + 1;
+    int w = static_cast<int>(std::ceil(r.x + r.width + c.origin.x)) + 2;
+    int h = static_cast<int>(std::ceil(r.y + r.height + c.origin.y)) + 2;
+    c.img.create(h, w, type);
+    return c;
+}
+
+/*
+ * @function rotateThreeShearCore
+ * @brief  |θ| <= 90° 时的三次剪切，src/dst 画布的原点即旋转中心
+ * @note   中间画布只保留最终输出用得到的部分：从 dst 的范围逆推回去，与正向包围盒取交集
+ */
+template <typename T, int CN>
+inline void rotateThreeShearCore(const ShearCanvas &src, ShearCanvas &dst, double angle)
+{
+    const double theta = angle * CV_PI / 180.0;
+    const double a = std::tan(theta / 2.0);
+    const double b = -std::sin(theta);
+
+    // 正向：源图像范围依次经过 x 剪切、y 剪切后的包围盒
+    const cv::Rect2d r0(-src.origin.x, -src.origin.y, src.img.cols, src.img.rows);
+    const cv::Rect2d r1 = shearBounds(r0, 1, a, 0, 1);
+    const cv::Rect2d r2 = shearBounds(r1, 1, 0, b, 1);
+
+    // 逆向：dst 的范围需要的 t2、t1 范围
+    const cv::Rect2d rd(-dst.origin.x, -dst.origin.y, dst.img.cols, dst.img.rows);
+    const cv::Rect2d need2 = shearIntersect(shearBounds(rd, 1, -a, 0, 1), r2);
+    const cv::Rect2d need1 = shearIntersect(shearBounds(need2, 1, 0, -b, 1), r1);
+    if (need2.width <= 0 || need2.height <= 0 || need1.width <= 0 || need1.height <= 0)
+    {
+        dst.img.setTo(cv::Scalar::all(0));
+        return;
+    }
+
+    // 第一趟 x 剪切：行与源图像对齐，列保持源图像的小数相位（角度为 0 时退化为整数平移）
+    ShearCanvas t1 = shearMakeCanvas(need1, src.origin, src.img.type());
+    shearPassX<T, CN>(src, t1, a);
+
+    // 第二趟 y 剪切：列与 t1 对齐；行的小数相位与 dst 一致，使第三趟的行能一一对应
+    ShearCanvas t2 = shearMakeCanvas(need2, cv::Point2d(t1.origin.x, dst.origin.y), src.img.type());
+    shearPassY<T, CN>(t1, t2, b);
+
+    // 第三趟 x 剪切：直接写入目标画布
+    shearPassX<T, CN>(t2, dst, a);
+}
+
+/*
+ * @function myRotateThreeShear
+ * @brief  Paeth 三次剪切旋转
+ * @param  src    输入图像（u8/u16/f32/f64，1~4 通道）
+ * @param  angle  旋转角度（逆时针，单位：度），与 myGetRotationMatrix2D 的约定相同
+ * @param  center 旋转中心（源图像坐标）
+ * @param  dsize  输出尺寸
+ * @param  shift  旋转后再整体平移的量（如把源中心移到更大画布的中心），默认不平移
+ * @return        旋转后的图像，源图像范围外填 0
+ */
+inline cv::Mat myRotateThreeShear(const cv::Mat &src, double angle, cv::Point2f center, cv::Size dsize,
+                                  cv::Point2d shift = cv::Point2d(0, 0))
+{
+    // 角度归一化到 (-180, 180]
+    angle = std::remainder(angle, 360.0);
+    if (angle == -180.0)
+        angle = 180.0;
+
+    ShearCanvas in{src, cv::Point2d(center.x, center.y)};
+    ShearCanvas out{cv::Mat(dsize, src.type()), cv::Point2d(center.x + shift.x, center.y + shift.y)};
+
+    myDispatchPixelType(src.type(), [&]<typename T, int CN>()
+                        {
+        if (std::abs(angle) <= 90.0)
+        {
+            rotateThreeShearCore<T, CN>(in, out, angle);
+            return;
+        }
+
+        // |θ| > 90°：拆成两次 θ/2，中间画布取对角线长度的正方形，保证不裁剪
+        int diag = static_cast<int>(std::ceil(std::hypot(src.cols, src.rows))) + 2;
+        ShearCanvas mid{cv::Mat(diag, diag, src.type()), cv::Point2d(diag / 2.0, diag / 2.0)};
+        rotateThreeShearCore<T, CN>(in, mid, angle / 2.0);
+        rotateThreeShearCore<T, CN>(mid, out, angle / 2.0); });
+
+    return out.img;
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+// track.hpp
+// 高斯金字塔 + 稀疏金字塔 Lucas-Kanade 点跟踪（序列配准用）
+//
+// 相邻帧之间差别很小，不必每帧重新检测、匹配特征，而是把上一帧的点在新帧中"跟"出来：
+//   - 每帧只建一次金字塔（float 图像 + 中心差分梯度），下一帧时直接作为"上一帧"复用
+//   - 每个点从最粗层开始迭代求位移，结果 ×2 作为下一层的初值，在最细层得到亚像素位置
+//   - 模板窗口（上一帧的灰度和梯度）与 2x2 结构张量每层只算一次，迭代中只采样当前帧
+// 各点相互独立，按点并行。
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*
+ * @struct TrackParams
+ * @brief  Lucas-Kanade 跟踪参数
+ */
+struct TrackParams
+{
+    int half_win = 7;     // 窗口半径，窗口为 (2*half_win+1)^2
+    int max_iters = 20;   // 每层最多迭代次数
+    float eps = 0.03f;    // 位移增量小于 eps 像素时停止迭代
+    float min_eig = 1.0f; // 结构张量最小特征值 / 窗口像素数的下限（灰度级^2），低于此值视为无纹理
+};
+
+/*
+ * @struct TrackPyramid
+ * @brief  一帧的高斯金字塔：img[0] 为原图，img[l] 为第 l 层（尺寸减半），均为 CV_32F；gx/gy 为对应梯度
+ */
+struct TrackPyramid
+{
+    std::vector<cv::Mat> img, gx, gy;
+
+    int levels() const { return static_cast<int>(img.size()); }
+
+    /*
+     * @function build
+     * @brief  由单通道 8 位图像建立金字塔
+     * @param  gray   输入图像（CV_8UC1）
+     * @param  levels 最多层数（含原图）；图像短边小于 32 时不再下采样
+     */
+    void build(const cv::Mat &gray, int levels);
+};
+
+// BORDER_REFLECT_101 下标
+inline int trackReflect101(int i, int n)
+{
+    if (n == 1)
+        return 0;
+    while (i < 0 || i >= n)
+        i = i < 0 ? -i : 2 * n - 2 - i;
+    return i;
+}
+
+/*
+ * @function myPyramidDown
+ * @brief  5 抽头 [1 4 6 4 1]/16 高斯平滑后隔行隔列采样（与 cv::pyrDown 相同的核和边界）
+ * @param  src CV_32FC1
+ * @return     ((cols+1)/2) x ((rows+1)/2) 的 CV_32FC1
+ */
+inline cv::Mat myPyramidDown(const cv::Mat &src)
+{
+    CV_Assert(src.type() == CV_32FC1);
+    const int sw = src.cols, sh = src.rows;
+    cv::Mat dst((sh + 1) / 2, (sw + 1) / 2, CV_32FC1);
+    const int dw = dst.cols;
+
+    // 水平方向只需要在偶数列求值：预先算好每个输出列的 5 个源列下标
+    std::vector<int> cols(dw * 5);
+    for (int x = 0; x < dw; ++x)
+        for (int t = 0; t < 5; ++t)
+            cols[x * 5 + t] = trackReflect101(2 * x + t - 2, sw);
+
+    cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range &r)
+                      {
+        std::vector<float> vsum(sw);
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const float *s0 = src.ptr<float>(trackReflect101(2 * y - 2, sh));
+            const float *s1 = src.ptr<float>(trackReflect101(2 * y - 1, sh));
+            const float *s2 = src.ptr<float>(trackReflect101(2 * y, sh));
+            const float *s3 = src.ptr<float>(trackReflect101(2 * y + 1, sh));
+            const float *s4 = src.ptr<float>(trackReflect101(2 * y + 2, sh));
+            for (int x = 0; x < sw; ++x)
+                vsum[x] = s0[x] + s4[x] + 4.f * (s1[x] + s3[x]) + 6.f * s2[x];
+
+            float *d = dst.ptr<float>(y);
+            const int *c = cols.data();
+            for (int x = 0; x < dw; ++x, c += 5)
+                d[x] = (vsum[c[0]] + vsum[c[4]] + 4.f * (vsum[c[1]] + vsum[c[3]]) + 6.f * vsum[c[2]]) * (1.f / 256.f);
+        } });
+    return dst;
+}
+
+/*
+ * @function trackGradients
+ * @brief  中心差分梯度（边界处复制边界像素）
+ */
+inline void trackGradients(const cv::Mat &img, cv::Mat &gx, cv::Mat &gy)
+{
+    const int w = img.cols, h = img.rows;
+    gx.create(h, w, CV_32FC1);
+    gy.create(h, w, CV_32FC1);
+    cv::parallel_for_(cv::Range(0, h), [&](const cv::Range &r)
+                      {
+        for (int y = r.start; y < r.end; ++y)
+        {
+            const float *up = img.ptr<float>(std::max(y - 1, 0));
+            const float *mid = img.ptr<float>(y);
+            const float *dn = img.ptr<float>(std::min(y + 1, h - 1));
+            float *ox = gx.ptr<float>(y), *oy = gy.ptr<float>(y);
+            for (int x = 0; x < w; ++x)
+            {
+                ox[x] = 0.5f * (mid[std::min(x + 1, w - 1)] - mid[std::max(x - 1, 0)]);
+                oy[x] = 0.5f * (dn[x] - up[x]);
+            }
+        } });
+}
+
+inline void TrackPyramid::build(const cv::Mat &gray, int levels)
+{
+    CV_Assert(gray.type() == CV_8UC1 && levels >= 1);
+    img.clear();
+    gx.clear();
+    gy.clear();
+
+    cv::Mat base(gray.rows, gray.cols, CV_32FC1);
+    for (int y = 0; y < gray.rows; ++y)
+    {
+        const uchar *s = gray.ptr<uchar>(y);
+        float *d = base.ptr<float>(y);
+        for (int x = 0; x < gray.cols; ++x)
+            d[x] = s[x];
+    }
+    img.push_back(base);
+    while (static_cast<int>(img.size()) < levels && std::min(img.back().cols, img.back().rows) >= 32)
+        img.push_back(myPyramidDown(img.back()));
+
+    gx.resize(img.size());
+    gy.resize(img.size());
+    for (size_t l = 0; l < img.size(); ++l)
+        trackGradients(img[l], gx[l], gy[l]);
+}
+
+/*
+ * @function trackSampleWindow
+ * @brief  以 (x0, y0) 为左上角双线性采样 n x n 窗口（所有像素共用同一组小数权重）
+ * @note   窗口越界时逐点截断坐标（复制边界）
+ */
+inline void trackSampleWindow(const cv::Mat &img, float x0, float y0, int n, float *out)
+{
+    const int ix = static_cast<int>(std::floor(x0)), iy = static_cast<int>(std::floor(y0));
+    const float ax = x0 - ix, ay = y0 - iy;
+    const float w00 = (1.f - ax) * (1.f - ay), w01 = ax * (1.f - ay), w10 = (1.f - ax) * ay, w11 = ax * ay;
+
+    if (ix >= 0 && iy >= 0 && ix + n < img.cols && iy + n < img.rows)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            const float *r0 = img.ptr<float>(iy + j) + ix;
+            const float *r1 = img.ptr<float>(iy + j + 1) + ix;
+            for (int i = 0; i < n; ++i)
+                out[j * n + i] = w00 * r0[i] + w01 * r0[i + 1] + w10 * r1[i] + w11 * r1[i + 1];
+        }
+        return;
+    }
+
+    const int w = img.cols, h = img.rows;
+    for (int j = 0; j < n; ++j)
+    {
+        const int ya = std::clamp(iy + j, 0, h - 1), yb = std::clamp(iy + j + 1, 0, h - 1);
+        const float *r0 = img.ptr<float>(ya), *r1 = img.ptr<float>(yb);
+        for (int i = 0; i < n; ++i)
+        {
+            const int xa = std::clamp(ix + i, 0, w - 1), xb = std::clamp(ix + i + 1, 0, w - 1);
+            out[j * n + i] = w00 * r0[xa] + w01 * r0[xb] + w10 * r1[xa] + w11 * r1[xb];
+        }
+    }
+}
+
+/*
+ * @function myTrackPoints
+ * @brief  金字塔 Lucas-Kanade：求 prev 中的点在 cur 中的位置（对应 cv::calcOpticalFlowPyrLK）
+ * @param  prev     上一帧金字塔
+ * @param  cur      当前帧金字塔（层数与 prev 相同）
+ * @param  prev_pts 上一帧中的点
+ * @param  cur_pts  输入：与 prev_pts 等长时作为初始位置（如由上一帧运动预测）；输出：跟踪结果
+ * @param  status   输出：1 表示跟踪成功；窗口无纹理或点移出图像时为 0
+ * @param  err      输出：最终窗口内的平均绝对灰度差
+ * @param  params   跟踪参数
+ */
+inline void myTrackPoints(const TrackPyramid &prev, const TrackPyramid &cur, const std::vector<cv::Point2f> &prev_pts,
+                          std::vector<cv::Point2f> &cur_pts, std::vector<uchar> &status, std::vector<float> &err,
+                          const TrackParams &params = TrackParams())
+{
+    CV_Assert(prev.levels() == cur.levels() && prev.levels() > 0);
+    CV_Assert(prev.img[0].size() == cur.img[0].size());
+    const int n_pts = static_cast<int>(prev_pts.size());
+    if (cur_pts.size() != prev_pts.size())
+        cur_pts = prev_pts;
+    status.assign(n_pts, 0);
+    err.assign(n_pts, 0.f);
+
+    const int levels = prev.levels();
+    const int win = 2 * params.half_win + 1, area = win * win;
+    const float eps2 = params.eps * params.eps;
+
+    cv::parallel_for_(cv::Range(0, n_pts), [&](const cv::Range &r)
+                      {
+        std::vector<float> tI(area), tX(area), tY(area), J(area);
+        for (int k = r.start; k < r.end; ++k)
+        {
+            const float scale0 = 1.f / static_cast<float>(1 << (levels - 1));
+            // 层内位移 d：最粗层由初始位置给出
+            float dx = (cur_pts[k].x - prev_pts[k].x) * scale0;
+            float dy = (cur_pts[k].y - prev_pts[k].y) * scale0;
+            bool ok = true;
+
+            for (int l = levels - 1; l >= 0 && ok; --l)
+            {
+                const float s = 1.f / static_cast<float>(1 << l);
+                const float px = prev_pts[k].x * s - params.half_win, py = prev_pts[k].y * s - params.half_win;
+
+                // 模板窗口与结构张量
+                trackSampleWindow(prev.img[l], px, py, win, tI.data());
+                trackSampleWindow(prev.gx[l], px, py, win, tX.data());
+                trackSampleWindow(prev.gy[l], px, py, win, tY.data());
+                double gxx = 0, gxy = 0, gyy = 0;
+                for (int i = 0; i < area; ++i)
+                {
+                    gxx += tX[i] * tX[i];
+                    gxy += tX[i] * tY[i];
+                    gyy += tY[i] * tY[i];
+                }
+                const double det = gxx * gyy - gxy * gxy;
+                const double min_eig = (gxx + gyy - std::sqrt((gxx - gyy) * (gxx - gyy) + 4. * gxy * gxy)) * 0.5;
+                if (min_eig / area < params.min_eig || det < 1e-9)
+                {
+                    ok = false;
+                    break;
+                }
+                const double inv_det = 1. / det;
+
+                for (int it = 0; it < params.max_iters; ++it)
+                {
+                    const float cx = px + dx, cy = py + dy;
+                    // 窗口中心完全离开当前层图像
+                    if (cx + params.half_win < -1.f || cy + params.half_win < -1.f ||
+                        cx + params.half_win > cur.img[l].cols || cy + params.half_win > cur.img[l].rows)
+                    {
+                        ok = false;
+                        break;
+                    }
+                    trackSampleWindow(cur.img[l], cx, cy, win, J.data());
+                    double bx = 0, by = 0;
+                    for (int i = 0; i < area; ++i)
+                    {
+                        const float diff = tI[i] - J[i];
+                        bx += diff * tX[i];
+                        by += diff * tY[i];
+                    }
+                    const float ux = static_cast<float>((gyy * bx - gxy * by) * inv_det);
+                    const float uy = static_cast<float>((gxx * by - gxy * bx) * inv_det);
+                    dx += ux;
+                    dy += uy;
+                    if (ux * ux + uy * uy < eps2)
+                        break;
+                }
+
+                if (l > 0)
+                {
+                    dx *= 2.f;
+                    dy *= 2.f;
+                }
+            }
+
+            if (!ok)
+                continue;
+            const float fx = prev_pts[k].x + dx, fy = prev_pts[k].y + dy;
+            if (!(fx >= 0.f && fy >= 0.f && fx <= cur.img[0].cols - 1 && fy <= cur.img[0].rows - 1))
+                continue;
+            cur_pts[k] = cv::Point2f(fx, fy);
+
+            // 最细层的残差作为跟踪质量（PROSAC 排序用）；tI 此时就是第 0 层的模板
+            trackSampleWindow(cur.img[0], fx - params.half_win, fy - params.half_win, win, J.data());
+            float e = 0;
+            for (int i = 0; i < area; ++i)
+                e += std::fabs(tI[i] - J[i]);
+            err[k] = e / area;
+            status[k] = 1;
+        } });
+}
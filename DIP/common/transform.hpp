@@ -0,0 +1,466 @@
+#pragma once
+
+// transform.hpp
+// 3x3 齐次变换矩阵的构造函数，以及把一串变换符号化地合成为一次重采样的变换链
+//
+// 每一步都是 3x3 正向矩阵，链的整体矩阵为 M_n * ... * M_2 * M_1（先执行 M_1）。
+// 执行时只对最终结果重采样一次，避免逐步变换累积的插值模糊和整幅图的内存往返；
+// 合成后为单位阵时直接拷贝，为整数平移时逐行 memcpy，为小数平移时走可分离的两抽头平移引擎。
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "warp.hpp"
+
+/*
+ * @function myGetRotationMatrix2D
+ * @brief  自定义计算旋转矩阵的函数
+ * @param  center 旋转中心
+ * @param  angle  旋转角度（逆时针，单位：度）
+ * @return        3x3 的旋转矩阵
+ * @note OpenCV 的 getRotationMatrix2D 返回的是 2x3 矩阵，这里为了方便学习理解，返回一个完整的 3x3 矩阵
+ */
+inline cv::Mat myGetRotationMatrix2D(cv::Point2f center, double angle)
+{
+    double alpha = std::cos(angle * CV_PI / 180.0);
+    double beta = std::sin(angle * CV_PI / 180.0);
+
+    cv::Mat rot_mat(3, 3, CV_64F);
+    rot_mat.at<double>(0, 0) = alpha;
+    rot_mat.at<double>(0, 1) = beta;
+    rot_mat.at<double>(0, 2) = (1 - alpha) * center.x - beta * center.y;
+    rot_mat.at<double>(1, 0) = -beta;
+    rot_mat.at<double>(1, 1) = alpha;
+    rot_mat.at<double>(1, 2) = beta * center.x + (1 - alpha) * center.y;
+    rot_mat.at<double>(2, 0) = 0.0;
+    rot_mat.at<double>(2, 1) = 0.0;
+    rot_mat.at<double>(2, 2) = 1.0;
+
+    return rot_mat;
+}
+
+/*
+ * @function myGetShearMatrix
+ * @brief  生成倾斜（剪切）变换矩阵
+ * @param  shx  x方向剪切系数
+ * @param  shy  y方向剪切系数
+ * @return      3x3 齐次变换矩阵
+ */
+inline cv::Mat myGetShearMatrix(double shx, double shy)
+{
+    cv::Mat shear_mat = (cv::Mat_<double>(3, 3) << 1, shx, 0,
+                         shy, 1, 0,
+                         0, 0, 1);
+    return shear_mat;
+}
+
+/*
+ * @function myGetMoveMatrix
+ * @brief  生成平移变换的齐次 3x3 矩阵
+ * @param  tx x 方向平移
+ * @param  ty y 方向平移
+ * @return     3x3 齐次变换矩阵
+ */
+inline cv::Mat myGetMoveMatrix(double tx, double ty)
+{
+    cv::Mat move_mat = (cv::Mat_<double>(3, 3) << 1, 0, tx,
+                        0, 1, ty,
+                        0, 0, 1);
+    return move_mat;
+}
+
+/*
+ * @function myGetScaleMatrix
+ * @brief  生成缩放变换的齐次 3x3 矩阵（以原点为中心）
+ * @param  scale_x x 方向缩放
+ * @param  scale_y y 方向缩放
+ * @return         3x3 齐次变换矩阵
+ */
+inline cv::Mat myGetScaleMatrix(double scale_x, double scale_y)
+{
+    cv::Mat scale_mat = (cv::Mat_<double>(3, 3) << scale_x, 0, 0,
+                         0, scale_y, 0,
+                         0, 0, 1);
+    return scale_mat;
+}
+
+/*
+ * @function myTranslateCopy
+ * @brief  整数平移：逐行 memcpy，其余部分填 0
+ * @param  src   输入图像
+ * @param  tx    x 方向平移（整数像素，可以为负）
+ * @param  ty    y 方向平移
+ * @param  dsize 输出尺寸
+ * @return       平移后的图像
+ */
+inline cv::Mat myTranslateCopy(const cv::Mat &src, int tx, int ty, cv::Size dsize)
+{
+    cv::Mat dst(dsize, src.type());
+    const size_t es = src.elemSize();
+
+    // 输出中能取到源像素的列区间 [x0, x1)
+    const int x0 = std::clamp(tx, 0, dsize.width);
+    const int x1 = std::clamp(tx + src.cols, x0, dsize.width);
+
+    for (int y = 0; y < dsize.height; ++y)
+    {
+        uchar *out = dst.ptr<uchar>(y);
+        const int sy = y - ty;
+        if (sy < 0 || sy >= src.rows || x0 == x1)
+        {
+            std::memset(out, 0, dsize.width * es);
+            continue;
+        }
+        std::memset(out, 0, x0 * es);
+        std::memcpy(out + x0 * es, src.ptr<uchar>(sy) + (x0 - tx) * es, (x1 - x0) * es);
+        std::memset(out + x1 * es, 0, (dsize.width - x1) * es);
+    }
+    return dst;
+}
+
+/*
+ * @struct TranslateAxis
+ * @brief  平移在一个轴上的采样方式：源下标 = 输出下标 + i（+1），两个抽头的权重在整幅图上固定
+ */
+struct TranslateAxis
+{
+    int i = 0;       // 第一个抽头的偏移
+    int taps = 1;    // 1：整数平移；2：小数平移
+    int w8 = 0;      // 第二个抽头的 8 位权重（u8 路径，0..255）
+    double wf = 0.0; // 第二个抽头的浮点权重（其余类型）
+};
+
+// 输出 = 源坐标 (o + offset)；u8 按 1/256 量化权重，量化后为 0 或 1 时退化为整数平移
+inline TranslateAxis myMakeTranslateAxis(double offset, bool quantize8)
+{
+    constexpr double eps = 1e-9;
+    TranslateAxis ax;
+    double f = offset - std::floor(offset);
+    ax.i = static_cast<int>(std::floor(offset));
+    if (quantize8)
+    {
+        ax.w8 = static_cast<int>(std::lround(f * 256.0));
+        if (ax.w8 == 256)
+        {
+            ++ax.i;
+            ax.w8 = 0;
+        }
+        ax.taps = ax.w8 == 0 ? 1 : 2;
+        ax.wf = ax.w8 / 256.0;
+    }
+    else
+    {
+        if (f > 1.0 - eps)
+        {
+            ++ax.i;
+            f = 0.0;
+        }
+        ax.taps = f < eps ? 1 : 2;
+        ax.wf = f;
+    }
+    return ax;
+}
+
+/*
+ * @function translateHorizontalRow
+ * @brief  水平方向两抽头混合 [xlo, xhi) 一段，u8 结果放大 256 倍存入 uint16，其余类型存浮点（f64 为 double，其余为 float）
+ */
+template <typename T, int CN, typename Acc>
+inline void translateHorizontalRow(const T *s, const TranslateAxis &ax, int xlo, int xhi, Acc *h)
+{
+    const T *pa = s + (xlo + ax.i) * CN;
+    const int n = (xhi - xlo) * CN;
+    if constexpr (std::is_same_v<T, uchar>)
+    {
+        const int wb = ax.w8, wa = 256 - ax.w8;
+        if (ax.taps == 1)
+            for (int k = 0; k < n; ++k)
+                h[k] = static_cast<Acc>(pa[k] << 8);
+        else
+            for (int k = 0; k < n; ++k)
+                h[k] = static_cast<Acc>(pa[k] * wa + pa[k + CN] * wb);
+    }
+    else
+    {
+        const Acc wb = ax.wf, wa = 1 - wb;
+        if (ax.taps == 1)
+            for (int k = 0; k < n; ++k)
+                h[k] = static_cast<Acc>(pa[k]);
+        else
+            for (int k = 0; k < n; ++k)
+                h[k] = static_cast<Acc>(pa[k] * wa + pa[k + CN] * wb);
+    }
+}
+
+/*
+ * @function myTranslate
+ * @brief  平移专用引擎：整数偏移逐行 memcpy，小数偏移用整幅图共享的两抽头水平 + 垂直混合
+ * @param  src   输入图像（u8/u16/f32/f64，1~4 通道）
+ * @param  tx    x 方向平移（可以为负，可以是小数）
+ * @param  ty    y 方向平移
+ * @param  dsize 输出尺寸
+ * @return       平移后的图像，取不到完整抽头的位置填 0
+ * @note 平移可分离且权重处处相同，不需要逐像素矩阵乘法和坐标计算：
+ *       每个输出行只做两段连续内存上的乘加（编译器可自动向量化），源行的水平结果在相邻输出行之间复用；
+ *       u8 路径全程整数：水平 8 位权重存 uint16，垂直再乘 8 位权重后 (+32768) >> 16
+ */
+inline cv::Mat myTranslate(const cv::Mat &src, double tx, double ty, cv::Size dsize)
+{
+    CV_Assert(!src.empty() && dsize.width > 0 && dsize.height > 0);
+
+    const bool is8u = src.depth() == CV_8U;
+    const TranslateAxis ax = myMakeTranslateAxis(-tx, is8u);
+    const TranslateAxis ay = myMakeTranslateAxis(-ty, is8u);
+    if (ax.taps == 1 && ay.taps == 1)
+        return myTranslateCopy(src, -ax.i, -ay.i, dsize);
+
+    cv::Mat dst(dsize, src.type());
+
+    // 所有抽头都落在源图像内的输出区间
+    const int xlo = std::clamp(-ax.i, 0, dsize.width);
+    const int xhi = std::clamp(src.cols - ax.taps + 1 - ax.i, xlo, dsize.width);
+    const int ylo = std::clamp(-ay.i, 0, dsize.height);
+    const int yhi = std::clamp(src.rows - ay.taps + 1 - ay.i, ylo, dsize.height);
+
+    myDispatchPixelType(src.type(), [&]<typename T, int CN>()
+                        {
+        using Acc = std::conditional_t<std::is_same_v<T, uchar>, uint16_t,
+                                       std::conditional_t<std::is_same_v<T, double>, double, float>>;
+        auto store = [](Acc v) -> T
+        {
+            if constexpr (std::is_floating_point_v<T>)
+                return static_cast<T>(v);
+            else
+                return pixelFromFloat<T>(v);
+        };
+        cv::parallel_for_(cv::Range(0, dsize.height), [&](const cv::Range &range)
+                          {
+            const int WN = dsize.width * CN, n = (xhi - xlo) * CN;
+            // 两行水平结果；cached[j] 记录 buf[j] 对应的源行，相邻输出行共享一个源行
+            std::vector<Acc> buf[2] = {std::vector<Acc>(std::max(n, 1)), std::vector<Acc>(std::max(n, 1))};
+            int cached[2] = {-1, -1};
+            auto hrow = [&](int sy) -> const Acc *
+            {
+                for (int j = 0; j < 2; ++j)
+                    if (cached[j] == sy)
+                        return buf[j].data();
+                // 保留紧邻的上一行（下一次调用会用到 sy 与 sy + 1）
+                int j = (cached[0] == sy - 1) ? 1 : 0;
+                translateHorizontalRow<T, CN>(src.ptr<T>(sy), ax, xlo, xhi, buf[j].data());
+                cached[j] = sy;
+                return buf[j].data();
+            };
+
+            for (int y = range.start; y < range.end; ++y)
+            {
+                T *o = dst.ptr<T>(y);
+                if (y < ylo || y >= yhi || n == 0)
+                {
+                    std::fill(o, o + WN, T(0));
+                    continue;
+                }
+                std::fill(o, o + xlo * CN, T(0));
+                std::fill(o + xhi * CN, o + WN, T(0));
+
+                T *po = o + xlo * CN;
+                const Acc *h0 = hrow(y + ay.i);
+                if constexpr (std::is_same_v<T, uchar>)
+                {
+                    if (ay.taps == 1)
+                    {
+                        for (int k = 0; k < n; ++k)
+                            po[k] = static_cast<uchar>((h0[k] + 128) >> 8);
+                    }
+                    else
+                    {
+                        const Acc *h1 = hrow(y + ay.i + 1);
+                        const uint32_t wb = ay.w8, wa = 256 - ay.w8;
+                        for (int k = 0; k < n; ++k)
+                            po[k] = static_cast<uchar>((h0[k] * wa + h1[k] * wb + 32768u) >> 16);
+                    }
+                }
+                else
+                {
+                    if (ay.taps == 1)
+                    {
+                        for (int k = 0; k < n; ++k)
+                            po[k] = store(h0[k]);
+                    }
+                    else
+                    {
+                        const Acc *h1 = hrow(y + ay.i + 1);
+                        const Acc wb = ay.wf, wa = 1 - wb;
+                        for (int k = 0; k < n; ++k)
+                            po[k] = store(h0[k] * wa + h1[k] * wb);
+                    }
+                }
+            } }); });
+
+    return dst;
+}
+
+/*
+ * @class TransformChain
+ * @brief  变换链：按执行顺序追加步骤，合成为一个矩阵后一次重采样
+ */
+class TransformChain
+{
+public:
+    // 判断单位阵 / 整数平移时使用的容差
+    static constexpr double kEps = 1e-9;
+
+    TransformChain() : m_(cv::Mat::eye(3, 3, CV_64F)) {}
+
+    // 追加任意 3x3 仿射或透视步骤
+    TransformChain &then(const cv::Mat &step)
+    {
+        CV_Assert(step.rows == 3 && step.cols == 3 && step.type() == CV_64F);
+        m_ = step * m_;
+        ++steps_;
+        return *this;
+    }
+
+    TransformChain &rotate(cv::Point2f center, double angle) { return then(myGetRotationMatrix2D(center, angle)); }
+    TransformChain &shear(double shx, double shy) { return then(myGetShearMatrix(shx, shy)); }
+    TransformChain &move(double tx, double ty) { return then(myGetMoveMatrix(tx, ty)); }
+    TransformChain &scale(double sx, double sy) { return then(myGetScaleMatrix(sx, sy)); }
+
+    // 追加另一条链中的全部步骤
+    TransformChain &then(const TransformChain &other)
+    {
+        m_ = other.m_ * m_;
+        steps_ += other.steps_;
+        return *this;
+    }
+
+    // 整条链的逆
+    TransformChain inverse() const
+    {
+        TransformChain inv;
+        inv.m_ = m_.inv();
+        inv.steps_ = steps_;
+        return inv;
+    }
+
+    const cv::Mat &matrix() const { return m_; }
+    int steps() const { return steps_; }
+
+    bool isAffine() const
+    {
+        return std::abs(at(2, 0)) < kEps && std::abs(at(2, 1)) < kEps && std::abs(at(2, 2) - 1.0) < kEps;
+    }
+
+    // 线性部分是否为单位阵（此时整条链只是平移）
+    bool isTranslation() const
+    {
+        return isAffine() && std::abs(at(0, 0) - 1.0) < kEps && std::abs(at(0, 1)) < kEps &&
+               std::abs(at(1, 0)) < kEps && std::abs(at(1, 1) - 1.0) < kEps;
+    }
+
+    bool isIntegerTranslation(int &tx, int &ty) const
+    {
+        if (!isTranslation())
+            return false;
+        double rx = std::round(at(0, 2)), ry = std::round(at(1, 2));
+        if (std::abs(at(0, 2) - rx) > kEps || std::abs(at(1, 2) - ry) > kEps)
+            return false;
+        tx = static_cast<int>(rx);
+        ty = static_cast<int>(ry);
+        return true;
+    }
+
+    bool isIdentity() const
+    {
+        int tx, ty;
+        return isIntegerTranslation(tx, ty) && tx == 0 && ty == 0;
+    }
+
+    /*
+     * @function outputRect
+     * @brief  源图像四个角经整条链映射后的包围盒（透视时要求四个角都在 w > 0 的一侧）
+     */
+    cv::Rect outputRect(cv::Size src_size) const
+    {
+        double xs[4] = {0.0, static_cast<double>(src_size.width), 0.0, static_cast<double>(src_size.width)};
+        double ys[4] = {0.0, 0.0, static_cast<double>(src_size.height), static_cast<double>(src_size.height)};
+        double min_x = 1e300, min_y = 1e300, max_x = -1e300, max_y = -1e300;
+        for (int i = 0; i < 4; ++i)
+        {
+            double w = at(2, 0) * xs[i] + at(2, 1) * ys[i] + at(2, 2);
+            CV_Assert(w > 0);
+            double px = (at(0, 0) * xs[i] + at(0, 1) * ys[i] + at(0, 2)) / w;
+            double py = (at(1, 0) * xs[i] + at(1, 1) * ys[i] + at(1, 2)) / w;
+            min_x = std::min(min_x, px);
+            max_x = std::max(max_x, px);
+            min_y = std::min(min_y, py);
+            max_y = std::max(max_y, py);
+        }
+        int x0 = static_cast<int>(std::floor(min_x)), y0 = static_cast<int>(std::floor(min_y));
+        return cv::Rect(x0, y0, static_cast<int>(std::ceil(max_x)) - x0, static_cast<int>(std::ceil(max_y)) - y0);
+    }
+
+    /*
+     * @function apply
+     * @brief  对 src 执行整条链，只重采样一次
+     * @param  src   输入图像
+     * @param  dsize 输出尺寸
+     * @return       变换后的图像
+     * @note 单位阵 -> 拷贝；整数平移 -> 逐行 memcpy；小数平移 -> myTranslate；仿射 -> myWarpAffine；其余 -> myWarpPerspective
+     */
+    cv::Mat apply(const cv::Mat &src, cv::Size dsize) const
+    {
+        int tx, ty;
+        if (isIntegerTranslation(tx, ty))
+        {
+            if (tx == 0 && ty == 0 && dsize == src.size())
+                return src.clone();
+            return myTranslateCopy(src, tx, ty, dsize);
+        }
+        if (isAffine())
+        {
+            // 容差内判为仿射时最后一行可能残留 ~1e-17 的误差（如 H * H^-1），而 myGetWarpCoeffs 要求精确的 [0 0 1]
+            cv::Mat a = affineMatrix();
+            if (isTranslation())
+                return myTranslate(src, a.at<double>(0, 2), a.at<double>(1, 2), dsize);
+            return myWarpAffine(src, a, dsize);
+        }
+        return myWarpPerspective(src, m_, dsize);
+    }
+
+    cv::Mat apply(const cv::Mat &src) const { return apply(src, src.size()); }
+
+    /*
+     * @function applyBounded
+     * @brief  输出尺寸取为变换结果的包围盒，并平移使其左上角对齐到 (0, 0)，不会裁掉任何内容
+     */
+    cv::Mat applyBounded(const cv::Mat &src) const
+    {
+        cv::Rect r = outputRect(src.size());
+        TransformChain shifted = *this;
+        shifted.move(-r.x, -r.y);
+        return shifted.apply(src, r.size());
+    }
+
+private:
+    cv::Mat m_;
+    int steps_ = 0;
+
+    double at(int r, int c) const { return m_.at<double>(r, c); }
+
+    // 除以 m(2,2) 并把最后一行置为精确的 [0 0 1]（仅在 isAffine() 成立时调用）
+    cv::Mat affineMatrix() const
+    {
+        cv::Mat a;
+        m_.convertTo(a, CV_64F, 1.0 / at(2, 2));
+        a.at<double>(2, 0) = 0.0;
+        a.at<double>(2, 1) = 0.0;
+        a.at<double>(2, 2) = 1.0;
+        return a;
+    }
+};
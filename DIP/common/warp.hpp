@@ -0,0 +1,436 @@
+#pragma once
+
+// warp.hpp
+// exp1/2 中 myRotate / myShear / myMove / myResize 共用的仿射变换引擎（header-only）
+//
+// 原来的实现对每个输出像素都通过 cv::Mat::at<double> 读取逆矩阵（myRotate 甚至在内层循环里求逆），
+// 这里改为：
+//   1. 正向 3x3 矩阵只求一次逆，系数读成普通 double
+//   2. 每一行先解析求出源坐标落在 [0, cols-1) x [0, rows-1) 内的区间 [lo, hi)，区间外直接 memset 为 0
+//   3. 区间内部不再做任何边界判断和 clamp；b*y 每行只算一次，x 以 4 个像素为一组递增
+//   4. AVX2 下一次 gather 4 个像素的 2x2 邻域，坐标与插值表达式的运算顺序与原实现完全相同，结果逐位一致
+//   5. cv::parallel_for_ 按行带多线程
+//   6. 内核按 <像素类型, 通道数> 模板化（u8/u16/f32/f64，1~4 通道），由 cv::Mat::type() 在运行时分发；
+//      AVX2 gather 路径只用于 CV_8UC1
+//   7. 透视变换（exp1/3 配准）：按输出块分发，行内齐次坐标线性递推，AVX2 下 8 路 float + rcp/牛顿迭代代替除法
+//
+// 注：源坐标没有用定点数累加。0.3 这类十进制系数在定点下与 double 的末位舍入不同，
+//     而插值结果恰好落在 .5 上的情况很常见（如 0.3*a + 0.7*b），会导致与原实现差 1。
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "pixel.hpp"
+
+/*
+ * @struct WarpAffineCoeffs
+ * @brief  逆映射系数：srcX = a*x + b*y + c，srcY = d*x + e*y + f
+ */
+struct WarpAffineCoeffs
+{
+    double a, b, c;
+    double d, e, f;
+};
+
+/*
+ * @function myGetWarpCoeffs
+ * @brief  由正向 3x3 齐次矩阵求出逆映射系数（整幅图只求一次逆）
+ * @param  M 3x3 正向变换矩阵（CV_64F），最后一行必须为 [0 0 1]
+ * @return   逆映射系数
+ */
+inline WarpAffineCoeffs myGetWarpCoeffs(const cv::Mat &M)
+{
+    CV_Assert(M.rows == 3 && M.cols == 3 && M.type() == CV_64F);
+    CV_Assert(M.at<double>(2, 0) == 0.0 && M.at<double>(2, 1) == 0.0 && M.at<double>(2, 2) == 1.0);
+
+    cv::Mat inv = M.inv();
+    return {inv.at<double>(0, 0), inv.at<double>(0, 1), inv.at<double>(0, 2),
+            inv.at<double>(1, 0), inv.at<double>(1, 1), inv.at<double>(1, 2)};
+}
+
+/*
+ * @function warpBilinearRef
+ * @brief  原实现中的双线性插值公式（调用者保证 0 <= srcX < cols-1, 0 <= srcY < rows-1）
+ * @param  out 输出像素（CN 个通道）
+ * @note   运算顺序不可改动，SIMD 路径以它为准做到逐位一致
+ */
+template <typename T, int CN>
+inline void warpBilinearRef(const cv::Mat &src, double srcX, double srcY, T *out)
+{
+    int x1 = static_cast<int>(std::floor(srcX));
+    int y1 = static_cast<int>(std::floor(srcY));
+
+    double dx = srcX - x1;
+    double dy = srcY - y1;
+
+    const T *r1 = src.ptr<T>(y1) + x1 * CN;
+    const T *r2 = src.ptr<T>(y1 + 1) + x1 * CN;
+    for (int c = 0; c < CN; ++c)
+    {
+        double f11 = r1[c], f12 = r1[CN + c];
+        double f21 = r2[c], f22 = r2[CN + c];
+
+        double value = f11 * (1 - dx) * (1 - dy) +
+                       f12 * dx * (1 - dy) +
+                       f21 * (1 - dx) * dy +
+                       f22 * dx * dy;
+
+        out[c] = pixelFromDouble<T>(value);
+    }
+}
+
+#if defined(__AVX2__)
+/*
+ * @function warpBilinear4
+ * @brief  一次处理 4 个连续输出像素（x, x+1, x+2, x+3）
+ * @param  xv  4 个像素的 x 坐标（double，整数值）
+ * @param  by  k.b * y，每行只算一次
+ * @param  ey  k.e * y
+ * @return     false 表示这组像素靠近源图像最后一行，gather 可能读出矩阵末尾，需要走标量路径
+ * @note   gather 每次读 4 字节（x1..x1+3），因此要求 y1 + 1 <= rows - 2
+ */
+inline bool warpBilinear4(const uchar *base, int step, int max_y1, const WarpAffineCoeffs &k,
+                          __m256d xv, __m256d by, __m256d ey, uchar *out)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+
+    // srcX = (a*x + b*y) + c，与原实现的求值顺序相同
+    __m256d sx = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(k.a), xv), by), _mm256_set1_pd(k.c));
+    __m256d sy = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(k.d), xv), ey), _mm256_set1_pd(k.f));
+
+    __m256d fx = _mm256_floor_pd(sx);
+    __m256d fy = _mm256_floor_pd(sy);
+    __m128i x1 = _mm256_cvttpd_epi32(fx);
+    __m128i y1 = _mm256_cvttpd_epi32(fy);
+    if (!_mm_testz_si128(_mm_cmpgt_epi32(y1, _mm_set1_epi32(max_y1)), _mm_set1_epi32(-1)))
+        return false;
+
+    __m256d dx = _mm256_sub_pd(sx, fx);
+    __m256d dy = _mm256_sub_pd(sy, fy);
+
+    __m128i off = _mm_add_epi32(_mm_mullo_epi32(y1, _mm_set1_epi32(step)), x1);
+    const int *gbase = reinterpret_cast<const int *>(base);
+    __m128i g1 = _mm_i32gather_epi32(gbase, off, 1);
+    __m128i g2 = _mm_i32gather_epi32(gbase, _mm_add_epi32(off, _mm_set1_epi32(step)), 1);
+
+    __m256d f11 = _mm256_cvtepi32_pd(_mm_and_si128(g1, byte_mask));
+    __m256d f12 = _mm256_cvtepi32_pd(_mm_and_si128(_mm_srli_epi32(g1, 8), byte_mask));
+    __m256d f21 = _mm256_cvtepi32_pd(_mm_and_si128(g2, byte_mask));
+    __m256d f22 = _mm256_cvtepi32_pd(_mm_and_si128(_mm_srli_epi32(g2, 8), byte_mask));
+
+    __m256d wx = _mm256_sub_pd(one, dx);
+    __m256d wy = _mm256_sub_pd(one, dy);
+
+    // 与 warpBilinearRef 完全相同的结合顺序：((t11 + t12) + t21) + t22，不使用 FMA
+    __m256d v = _mm256_mul_pd(_mm256_mul_pd(f11, wx), wy);
+    v = _mm256_add_pd(v, _mm256_mul_pd(_mm256_mul_pd(f12, dx), wy));
+    v = _mm256_add_pd(v, _mm256_mul_pd(_mm256_mul_pd(f21, wx), dy));
+    v = _mm256_add_pd(v, _mm256_mul_pd(_mm256_mul_pd(f22, dx), dy));
+
+    // std::round 对非负数是“半数远离零”：截断后若小数部分 >= 0.5 再加 1
+    __m256d t = _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256d carry = _mm256_and_pd(_mm256_cmp_pd(_mm256_sub_pd(v, t), half, _CMP_GE_OQ), one);
+    __m128i r = _mm256_cvttpd_epi32(_mm256_add_pd(t, carry));
+
+    r = _mm_packus_epi16(_mm_packus_epi32(r, r), r);
+    int packed = _mm_cvtsi128_si32(r);
+    std::memcpy(out, &packed, 4);
+    return true;
+}
+#endif
+
+/*
+ * @function warpSolveSpan
+ * @brief  求出一行中源坐标落在图像内部的输出区间 [lo, hi)
+ * @note   先用 double 解线性不等式估计区间，再用原实现的判定条件逐个修正端点，
+ *         因此哪些像素被跳过与原实现完全一致
+ */
+inline void warpSolveSpan(const WarpAffineCoeffs &k, int y, int cols, int rows, int width, int &lo, int &hi)
+{
+    auto inside = [&](int x)
+    {
+        double srcX = k.a * x + k.b * y + k.c;
+        double srcY = k.d * x + k.e * y + k.f;
+        return !(srcX < 0 || srcX >= cols - 1 || srcY < 0 || srcY >= rows - 1);
+    };
+
+    // 对 v0 + x*dv 在 [0, limit) 内的 x 求连续实数区间，并与 [lo_r, hi_r] 取交集
+    double lo_r = 0.0, hi_r = width - 1.0;
+    auto clip = [&](double v0, double dv, double limit)
+    {
+        if (dv == 0.0)
+        {
+            if (v0 < 0 || v0 >= limit)
+                hi_r = -1.0;
+            return;
+        }
+        double t0 = (0.0 - v0) / dv, t1 = (limit - v0) / dv;
+        lo_r = std::max(lo_r, std::min(t0, t1));
+        hi_r = std::min(hi_r, std::max(t0, t1));
+    };
+    clip(k.b * y + k.c, k.a, cols - 1.0);
+    clip(k.e * y + k.f, k.d, rows - 1.0);
+
+    if (hi_r < lo_r)
+    {
+        lo = hi = 0;
+        return;
+    }
+
+    lo = std::clamp(static_cast<int>(std::ceil(lo_r)), 0, width);
+    hi = std::clamp(static_cast<int>(std::floor(hi_r)) + 1, lo, width);
+
+    // 端点修正：区间是凸的，向内收缩或向外扩张都只需看边界上的像素
+    while (lo < hi && !inside(lo))
+        ++lo;
+    while (hi > lo && !inside(hi - 1))
+        --hi;
+    if (lo == hi)
+        return;
+    while (lo > 0 && inside(lo - 1))
+        --lo;
+    while (hi < width && inside(hi))
+        ++hi;
+}
+
+/*
+ * @function warpAffineRow
+ * @brief  处理输出图像的一行：区间外清零，区间内插值
+ */
+template <typename T, int CN>
+inline void warpAffineRow(const cv::Mat &src, const WarpAffineCoeffs &k, int y, T *out, int width)
+{
+    int lo, hi;
+    warpSolveSpan(k, y, src.cols, src.rows, width, lo, hi);
+
+    std::fill(out, out + lo * CN, T(0));
+    std::fill(out + hi * CN, out + width * CN, T(0));
+
+    int x = lo;
+#if defined(__AVX2__)
+    if constexpr (std::is_same_v<T, uchar> && CN == 1)
+    {
+        const __m256d by = _mm256_set1_pd(k.b * y);
+        const __m256d ey = _mm256_set1_pd(k.e * y);
+        __m256d xv = _mm256_setr_pd(x, x + 1, x + 2, x + 3);
+        const __m256d four = _mm256_set1_pd(4.0);
+        for (; x + 4 <= hi; x += 4, xv = _mm256_add_pd(xv, four))
+        {
+            if (!warpBilinear4(src.ptr<uchar>(0), static_cast<int>(src.step), src.rows - 3, k, xv, by, ey, out + x))
+            {
+                for (int i = 0; i < 4; ++i)
+                    warpBilinearRef<T, CN>(src, k.a * (x + i) + k.b * y + k.c, k.d * (x + i) + k.e * y + k.f, out + x + i);
+            }
+        }
+    }
+#endif
+    for (; x < hi; ++x)
+        warpBilinearRef<T, CN>(src, k.a * x + k.b * y + k.c, k.d * x + k.e * y + k.f, out + x * CN);
+}
+
+/*
+ * @function myWarpAffine
+ * @brief  通用仿射变换：逆映射 + 双线性插值，源图像范围外填 0
+ * @param  src   输入图像（u8/u16/f32/f64，1~4 通道）
+ * @param  M     3x3 正向齐次变换矩阵（CV_64F）
+ * @param  dsize 输出图像尺寸
+ * @return       变换后的图像，类型与 src 相同
+ * @note 结果与原来逐像素 at<double> 的实现一致；多线程按行带划分
+ */
+inline cv::Mat myWarpAffine(const cv::Mat &src, const cv::Mat &M, cv::Size dsize)
+{
+    WarpAffineCoeffs k = myGetWarpCoeffs(M);
+    cv::Mat dst(dsize, src.type());
+
+    myDispatchPixelType(src.type(), [&]<typename T, int CN>()
+                        { cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range &range)
+                                            {
+            for (int y = range.start; y < range.end; ++y)
+                warpAffineRow<T, CN>(src, k, y, dst.ptr<T>(y), dst.cols); }); });
+
+    return dst;
+}
+
+// 透视变换按输出块划分任务：一个块对应的源区域集中，gather 基本都命中缓存；
+// 块写完时仍在 L1/L2 中，调用方的逐块回调（叠加、拼接等）可以直接读它，不必再遍历整幅图
+constexpr int kWarpTileW = 256;
+constexpr int kWarpTileH = 32;
+
+#if defined(__AVX2__)
+/*
+ * @function warpPerspective8
+ * @brief  一次处理 8 个连续输出像素（CV_8UC1），齐次坐标与插值都用 float
+ * @param  X, Y, W 8 个像素的齐次坐标
+ * @note   1/W 用 rcp（12 位精度）加一次牛顿迭代 r = r*(2 - W*r)，精度约 22 位，代替逐像素除法；
+ *         第二行的 gather 从 x1-2 开始读 4 字节，保证最后一行也不会读出矩阵末尾
+ */
+inline void warpPerspective8(const uchar *base, int step, int cols, int rows, __m256 X, __m256 Y, __m256 W, uchar *out)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 r = _mm256_rcp_ps(W);
+    r = _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(2.0f), _mm256_mul_ps(W, r)));
+    // 商再用残差修正一次 q += r*(X - W*q)：W 恰为 1（仿射）或整数坐标时得到精确的商，
+    // 否则落在 0 / cols-1 边界上的像素会因为 r 的末位误差被错判为越界
+    __m256 sx = _mm256_mul_ps(X, r);
+    __m256 sy = _mm256_mul_ps(Y, r);
+    sx = _mm256_add_ps(sx, _mm256_mul_ps(r, _mm256_sub_ps(X, _mm256_mul_ps(W, sx))));
+    sy = _mm256_add_ps(sy, _mm256_mul_ps(r, _mm256_sub_ps(Y, _mm256_mul_ps(W, sy))));
+
+    // 与标量路径相同的判定：w > 0 且 0 <= srcX < cols-1, 0 <= srcY < rows-1（NaN 视为越界）
+    __m256 valid = _mm256_cmp_ps(W, zero, _CMP_GT_OQ);
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(sx, zero, _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(sx, _mm256_set1_ps(cols - 1.0f), _CMP_LT_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(sy, zero, _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(sy, _mm256_set1_ps(rows - 1.0f), _CMP_LT_OQ));
+    if (_mm256_testz_ps(valid, valid))
+    {
+        std::memset(out, 0, 8);
+        return;
+    }
+    const __m256i vmask = _mm256_castps_si256(valid);
+
+    __m256 fx = _mm256_floor_ps(sx);
+    __m256 fy = _mm256_floor_ps(sy);
+    __m256 dx = _mm256_and_ps(_mm256_sub_ps(sx, fx), valid);
+    __m256 dy = _mm256_and_ps(_mm256_sub_ps(sy, fy), valid);
+
+    // 越界 lane 的偏移置 0，只读图像开头，结果最后被掩掉
+    __m256i off = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(fy), _mm256_set1_epi32(step)),
+                                   _mm256_cvttps_epi32(fx));
+    __m256i off1 = _mm256_and_si256(off, vmask);
+    __m256i off2 = _mm256_and_si256(_mm256_add_epi32(off, _mm256_set1_epi32(step - 2)), vmask);
+
+    const int *gbase = reinterpret_cast<const int *>(base);
+    __m256i g1 = _mm256_i32gather_epi32(gbase, off1, 1);
+    __m256i g2 = _mm256_i32gather_epi32(gbase, off2, 1);
+
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    __m256 f11 = _mm256_cvtepi32_ps(_mm256_and_si256(g1, byte_mask));
+    __m256 f12 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(g1, 8), byte_mask));
+    __m256 f21 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(g2, 16), byte_mask));
+    __m256 f22 = _mm256_cvtepi32_ps(_mm256_srli_epi32(g2, 24));
+
+    __m256 wx = _mm256_sub_ps(one, dx);
+    __m256 wy = _mm256_sub_ps(one, dy);
+    __m256 v = _mm256_mul_ps(_mm256_mul_ps(f11, wx), wy);
+    v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_mul_ps(f12, dx), wy));
+    v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_mul_ps(f21, wx), dy));
+    v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_mul_ps(f22, dx), dy));
+
+    // v >= 0，截断 v + 0.5 即四舍五入
+    __m256i q = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_add_ps(v, _mm256_set1_ps(0.5f))), vmask);
+    __m128i q16 = _mm_packus_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(q16, q16));
+}
+#endif
+
+/*
+ * @function warpPerspectiveRow
+ * @brief  处理输出一行中的 [x0, x1) 一段
+ * @param  m   逆单应矩阵（行优先 9 个系数）
+ * @param  out 该行第 x0 个像素的地址
+ * @note   一行内齐次坐标是 x 的线性函数：X = m0*x + (m1*y + m2)，常数项每行只算一次
+ */
+template <typename T, int CN>
+inline void warpPerspectiveRow(const cv::Mat &src, const double *m, int y, int x0, int x1, T *out)
+{
+    const double cx = m[1] * y + m[2];
+    const double cy = m[4] * y + m[5];
+    const double cw = m[7] * y + m[8];
+
+    int x = x0;
+#if defined(__AVX2__)
+    if constexpr (std::is_same_v<T, uchar> && CN == 1)
+    {
+        // 每组 8 个像素的起点用 double 求出，组内增量用 float，避免整行累加误差
+        const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256 dX = _mm256_mul_ps(lane, _mm256_set1_ps(static_cast<float>(m[0])));
+        const __m256 dY = _mm256_mul_ps(lane, _mm256_set1_ps(static_cast<float>(m[3])));
+        const __m256 dW = _mm256_mul_ps(lane, _mm256_set1_ps(static_cast<float>(m[6])));
+        const uchar *base = src.ptr<uchar>(0);
+        const int step = static_cast<int>(src.step);
+        for (; x + 8 <= x1; x += 8)
+        {
+            __m256 X = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(m[0] * x + cx)), dX);
+            __m256 Y = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(m[3] * x + cy)), dY);
+            __m256 W = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(m[6] * x + cw)), dW);
+            warpPerspective8(base, step, src.cols, src.rows, X, Y, W, out + (x - x0));
+        }
+    }
+#endif
+    for (; x < x1; ++x)
+    {
+        T *o = out + (x - x0) * CN;
+        double w = m[6] * x + cw;
+        std::fill(o, o + CN, T(0));
+        if (w <= 0)
+            continue;
+        double srcX = (m[0] * x + cx) / w;
+        double srcY = (m[3] * x + cy) / w;
+        if (srcX < 0 || srcX >= src.cols - 1 || srcY < 0 || srcY >= src.rows - 1)
+            continue;
+        warpBilinearRef<T, CN>(src, srcX, srcY, o);
+    }
+}
+
+/*
+ * @function myWarpPerspectiveTiled
+ * @brief  分块透视变换，写入调用方给出的 dst（可以是更大图像中的 ROI）
+ * @param  src  输入图像（u8/u16/f32/f64，1~4 通道）
+ * @param  H    3x3 正向单应矩阵（CV_64F）
+ * @param  dst  输出图像，需预先分配，类型与 src 相同
+ * @param  hook 每个输出块写完后调用 hook(const cv::Rect &tile)，可在块仍在缓存中时做融合处理
+ * @note   块由 cv::parallel_for_ 的线程池分发；hook 会被多个线程并发调用（各自处理不相交的块）
+ */
+template <typename TileHook>
+inline void myWarpPerspectiveTiled(const cv::Mat &src, const cv::Mat &H, cv::Mat &dst, TileHook &&hook)
+{
+    CV_Assert(H.rows == 3 && H.cols == 3 && H.type() == CV_64F);
+    CV_Assert(!dst.empty() && dst.type() == src.type());
+
+    cv::Mat inv = H.inv();
+    const double *m = inv.ptr<double>(0);
+    const int tiles_x = (dst.cols + kWarpTileW - 1) / kWarpTileW;
+    const int tiles_y = (dst.rows + kWarpTileH - 1) / kWarpTileH;
+
+    myDispatchPixelType(src.type(), [&]<typename T, int CN>()
+                        { cv::parallel_for_(cv::Range(0, tiles_x * tiles_y), [&](const cv::Range &range)
+                                            {
+            for (int t = range.start; t < range.end; ++t)
+            {
+                const int tx = (t % tiles_x) * kWarpTileW, ty = (t / tiles_x) * kWarpTileH;
+                const cv::Rect tile(tx, ty, std::min(kWarpTileW, dst.cols - tx), std::min(kWarpTileH, dst.rows - ty));
+                for (int y = tile.y; y < tile.y + tile.height; ++y)
+                    warpPerspectiveRow<T, CN>(src, m, y, tile.x, tile.x + tile.width, dst.ptr<T>(y) + tile.x * CN);
+                hook(tile);
+            } }); });
+}
+
+/*
+ * @function myWarpPerspective
+ * @brief  通用透视变换：逆映射 + 双线性插值，源图像范围外（或齐次坐标 w <= 0）填 0
+ * @param  src   输入图像（u8/u16/f32/f64，1~4 通道）
+ * @param  H     3x3 正向单应矩阵（CV_64F）
+ * @param  dsize 输出图像尺寸
+ * @return       变换后的图像，类型与 src 相同
+ * @note 插值公式与仿射路径相同；CV_8UC1 在 AVX2 下走 float 坐标的 8 路 SIMD，与 double 标量路径可能差 1
+ */
+inline cv::Mat myWarpPerspective(const cv::Mat &src, const cv::Mat &H, cv::Size dsize)
+{
+    cv::Mat dst(dsize, src.type());
+    myWarpPerspectiveTiled(src, H, dst, [](const cv::Rect &) {});
+    return dst;
+}
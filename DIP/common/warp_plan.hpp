@@ -0,0 +1,491 @@
+#pragma once
+
+// warp_plan.hpp
+// 预计算的重映射表（warp plan）：同一尺寸、同一矩阵的变换只建一次表，之后每幅图只做一次流式 gather
+//
+// 每个输出行只记录落在源图像内部的区间 [lo, hi)，区间内每个像素存：
+//   int16 源坐标 (x1, y1) + 8 位小数权重 (wx, wy)，共 6 字节
+// 应用时没有任何矩阵运算，也不再判断边界。
+// 计划可以保存到磁盘（先写临时文件再 rename），后续进程直接加载，不必重新构建；内存中按 LRU 只常驻有限个计划。
+
+#include <opencv2/opencv.hpp>
+
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "pixel.hpp"
+#include "warp.hpp"
+
+/*
+ * @struct WarpPlanKey
+ * @brief  计划的键：源尺寸、目标尺寸、3x3 正向矩阵、插值方式
+ */
+struct WarpPlanKey
+{
+    cv::Size src_size;
+    cv::Size dst_size;
+    double m[9] = {};
+    int interp = cv::INTER_LINEAR;
+
+    bool operator==(const WarpPlanKey &o) const
+    {
+        return src_size == o.src_size && dst_size == o.dst_size && interp == o.interp &&
+               std::memcmp(m, o.m, sizeof(m)) == 0;
+    }
+
+    // FNV-1a，矩阵按位参与计算；同时用作磁盘文件名
+    uint64_t hash() const
+    {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&](const void *p, size_t n)
+        {
+            const unsigned char *b = static_cast<const unsigned char *>(p);
+            for (size_t i = 0; i < n; ++i)
+                h = (h ^ b[i]) * 1099511628211ULL;
+        };
+        int dims[5] = {src_size.width, src_size.height, dst_size.width, dst_size.height, interp};
+        mix(dims, sizeof(dims));
+        mix(m, sizeof(m));
+        return h;
+    }
+};
+
+struct WarpPlanKeyHash
+{
+    size_t operator()(const WarpPlanKey &k) const { return static_cast<size_t>(k.hash()); }
+};
+
+/*
+ * @function myMakeWarpPlanKey
+ * @brief  由矩阵构造键，2x3 仿射矩阵（如 cv::getRotationMatrix2D 的结果）会补成 3x3
+ */
+inline WarpPlanKey myMakeWarpPlanKey(cv::Size src_size, const cv::Mat &M, cv::Size dst_size, int interp)
+{
+    CV_Assert((M.rows == 2 || M.rows == 3) && M.cols == 3 && M.type() == CV_64F);
+    CV_Assert(interp == cv::INTER_NEAREST || interp == cv::INTER_LINEAR);
+
+    WarpPlanKey key;
+    key.src_size = src_size;
+    key.dst_size = dst_size;
+    key.interp = interp;
+    for (int r = 0; r < M.rows; ++r)
+        for (int c = 0; c < 3; ++c)
+            key.m[r * 3 + c] = M.at<double>(r, c);
+    if (M.rows == 2)
+        key.m[8] = 1.0;
+    return key;
+}
+
+/*
+ * @class WarpPlan
+ * @brief  一次构建、反复应用的重映射表
+ */
+class WarpPlan
+{
+public:
+    // 权重的定点精度：w / 256
+    static constexpr int kWeightBits = 8;
+    static constexpr int kWeightOne = 1 << kWeightBits;
+
+    WarpPlan() = default;
+
+    /*
+     * @function build
+     * @brief  按键构建计划，源坐标计算和越界判断与 myWarpAffine 相同
+     */
+    static WarpPlan build(const WarpPlanKey &key)
+    {
+        CV_Assert(key.src_size.width <= INT16_MAX && key.src_size.height <= INT16_MAX);
+
+        WarpPlan plan;
+        plan.key_ = key;
+
+        cv::Mat M(3, 3, CV_64F);
+        std::memcpy(M.ptr<double>(0), key.m, sizeof(key.m));
+        WarpAffineCoeffs k = myGetWarpCoeffs(M);
+
+        const int cols = key.src_size.width, rows = key.src_size.height;
+        const bool nearest = key.interp == cv::INTER_NEAREST;
+
+        plan.row_lo_.resize(key.dst_size.height);
+        plan.row_hi_.resize(key.dst_size.height);
+        plan.row_offset_.resize(key.dst_size.height + 1, 0);
+
+        for (int y = 0; y < key.dst_size.height; ++y)
+        {
+            int lo, hi;
+            if (nearest)
+                nearestSpan(k, y, cols, rows, key.dst_size.width, lo, hi);
+            else
+                warpSolveSpan(k, y, cols, rows, key.dst_size.width, lo, hi);
+
+            plan.row_lo_[y] = lo;
+            plan.row_hi_[y] = hi;
+            plan.row_offset_[y + 1] = plan.row_offset_[y] + (hi - lo);
+
+            for (int x = lo; x < hi; ++x)
+            {
+                double srcX = k.a * x + k.b * y + k.c;
+                double srcY = k.d * x + k.e * y + k.f;
+
+                if (nearest)
+                {
+                    plan.sx_.push_back(static_cast<int16_t>(std::lround(srcX)));
+                    plan.sy_.push_back(static_cast<int16_t>(std::lround(srcY)));
+                    plan.wx_.push_back(0);
+                    plan.wy_.push_back(0);
+                    continue;
+                }
+
+                int x1 = static_cast<int>(std::floor(srcX));
+                int y1 = static_cast<int>(std::floor(srcY));
+                int wx = static_cast<int>(std::lround((srcX - x1) * kWeightOne));
+                int wy = static_cast<int>(std::lround((srcY - y1) * kWeightOne));
+                quantize(x1, wx, cols);
+                quantize(y1, wy, rows);
+
+                plan.sx_.push_back(static_cast<int16_t>(x1));
+                plan.sy_.push_back(static_cast<int16_t>(y1));
+                plan.wx_.push_back(static_cast<uint8_t>(wx));
+                plan.wy_.push_back(static_cast<uint8_t>(wy));
+            }
+        }
+        return plan;
+    }
+
+    /*
+     * @function apply
+     * @brief  对一幅源图像执行重映射（u8/u16/f32/f64，1~4 通道）
+     * @note   dst 会被（重新）分配为 dst_size，区间外填 0
+     */
+    void apply(const cv::Mat &src, cv::Mat &dst) const
+    {
+        CV_Assert(src.size() == key_.src_size);
+        dst.create(key_.dst_size, src.type());
+
+        myDispatchPixelType(src.type(), [&]<typename T, int CN>()
+                            { applyTyped<T, CN>(src, dst); });
+    }
+
+    /*
+     * @function save
+     * @brief  以二进制格式保存到磁盘（先写临时文件再 rename，中断或多个进程同时写入都不会在正式路径上留下半个文件）
+     * @return 是否写入成功
+     */
+    bool save(const std::string &path) const
+    {
+        const std::string tmp = path + ".tmp" + std::to_string(::getpid());
+        {
+            std::ofstream ofs(tmp, std::ios::binary);
+            if (!ofs)
+                return false;
+
+            ofs.write(kMagic, 4);
+            writePod(ofs, kVersion);
+            writePod(ofs, key_.src_size.width);
+            writePod(ofs, key_.src_size.height);
+            writePod(ofs, key_.dst_size.width);
+            writePod(ofs, key_.dst_size.height);
+            writePod(ofs, key_.interp);
+            ofs.write(reinterpret_cast<const char *>(key_.m), sizeof(key_.m));
+
+            writeVec(ofs, row_lo_);
+            writeVec(ofs, row_hi_);
+            writeVec(ofs, row_offset_);
+            writeVec(ofs, sx_);
+            writeVec(ofs, sy_);
+            writeVec(ofs, wx_);
+            writeVec(ofs, wy_);
+            ofs.close();
+            if (!ofs)
+            {
+                std::error_code ec;
+                std::filesystem::remove(tmp, ec);
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec)
+            std::filesystem::remove(tmp, ec);
+        return !ec;
+    }
+
+    /*
+     * @function load
+     * @brief  从磁盘加载计划
+     * @return 文件不存在、格式或版本不符时返回 false
+     */
+    bool load(const std::string &path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs)
+            return false;
+
+        char magic[4];
+        int version = 0;
+        ifs.read(magic, 4);
+        readPod(ifs, version);
+        if (!ifs || std::memcmp(magic, kMagic, 4) != 0 || version != kVersion)
+            return false;
+
+        WarpPlan plan;
+        readPod(ifs, plan.key_.src_size.width);
+        readPod(ifs, plan.key_.src_size.height);
+        readPod(ifs, plan.key_.dst_size.width);
+        readPod(ifs, plan.key_.dst_size.height);
+        readPod(ifs, plan.key_.interp);
+        ifs.read(reinterpret_cast<char *>(plan.key_.m), sizeof(plan.key_.m));
+
+        bool ok = readVec(ifs, plan.row_lo_) && readVec(ifs, plan.row_hi_) && readVec(ifs, plan.row_offset_) &&
+                  readVec(ifs, plan.sx_) && readVec(ifs, plan.sy_) && readVec(ifs, plan.wx_) && readVec(ifs, plan.wy_);
+        if (!ok || !plan.consistent())
+            return false;
+
+        *this = std::move(plan);
+        return true;
+    }
+
+    const WarpPlanKey &key() const { return key_; }
+    bool empty() const { return row_offset_.empty(); }
+    // 计划占用的字节数（不含键）
+    size_t bytes() const
+    {
+        return (row_lo_.size() + row_hi_.size() + row_offset_.size()) * sizeof(int) +
+               (sx_.size() + sy_.size()) * sizeof(int16_t) + wx_.size() + wy_.size();
+    }
+
+private:
+    static constexpr char kMagic[4] = {'W', 'P', 'L', 'N'};
+    static constexpr int kVersion = 1;
+
+    WarpPlanKey key_;
+    std::vector<int> row_lo_, row_hi_;
+    std::vector<int> row_offset_; // 第 y 行的第一个像素在下面数组中的下标
+    std::vector<int16_t> sx_, sy_;
+    std::vector<uint8_t> wx_, wy_;
+
+    // 权重四舍五入到 256 时进位到下一个像素；进位后若越过 cols-2，退回并取最大权重
+    static void quantize(int &i1, int &w, int n)
+    {
+        if (w == kWeightOne)
+        {
+            ++i1;
+            w = 0;
+        }
+        if (i1 > n - 2)
+        {
+            i1 = n - 2;
+            w = kWeightOne - 1;
+        }
+    }
+
+    // 最近邻：四舍五入后的坐标落在 [0, n-1] 内即有效，仿射变换下同样是一段连续区间
+    static void nearestSpan(const WarpAffineCoeffs &k, int y, int cols, int rows, int width, int &lo, int &hi)
+    {
+        auto inside = [&](int x)
+        {
+            long sx = std::lround(k.a * x + k.b * y + k.c);
+            long sy = std::lround(k.d * x + k.e * y + k.f);
+            return sx >= 0 && sx < cols && sy >= 0 && sy < rows;
+        };
+        lo = 0;
+        while (lo < width && !inside(lo))
+            ++lo;
+        hi = lo;
+        while (hi < width && inside(hi))
+            ++hi;
+    }
+
+    // 加载的文件可能被截断、改动或损坏：applyTyped 不做边界检查，这里逐项校验它依赖的全部不变量
+    bool consistent() const
+    {
+        const int w = key_.dst_size.width, h = key_.dst_size.height;
+        const int cols = key_.src_size.width, rows = key_.src_size.height;
+        if (w < 0 || h < 0 || cols <= 0 || rows <= 0)
+            return false;
+        if (key_.interp != cv::INTER_NEAREST && key_.interp != cv::INTER_LINEAR)
+            return false;
+        if (row_lo_.size() != static_cast<size_t>(h) || row_hi_.size() != static_cast<size_t>(h) ||
+            row_offset_.size() != static_cast<size_t>(h) + 1 || row_offset_[0] != 0)
+            return false;
+
+        // 每行区间在 [0, width] 内，偏移按区间长度递增
+        for (int y = 0; y < h; ++y)
+        {
+            const int lo = row_lo_[y], hi = row_hi_[y];
+            if (lo < 0 || lo > hi || hi > w)
+                return false;
+            if (static_cast<int64_t>(row_offset_[y + 1]) - row_offset_[y] != hi - lo)
+                return false;
+        }
+        const size_t n = static_cast<size_t>(row_offset_.back());
+        if (sx_.size() != n || sy_.size() != n || wx_.size() != n || wy_.size() != n)
+            return false;
+
+        // 源坐标：最近邻读 (sx, sy)，双线性还要读右、下邻点
+        const int margin = key_.interp == cv::INTER_NEAREST ? 1 : 2;
+        for (size_t i = 0; i < n; ++i)
+            if (sx_[i] < 0 || sx_[i] > cols - margin || sy_[i] < 0 || sy_[i] > rows - margin)
+                return false;
+        return true;
+    }
+
+    template <typename T, int CN>
+    void applyTyped(const cv::Mat &src, cv::Mat &dst) const
+    {
+        const bool nearest = key_.interp == cv::INTER_NEAREST;
+        const size_t step = src.step / sizeof(T);
+        const T *base = src.ptr<T>(0);
+
+        cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range &range)
+                          {
+            for (int y = range.start; y < range.end; ++y)
+            {
+                T *out = dst.ptr<T>(y);
+                const int lo = row_lo_[y], hi = row_hi_[y];
+                std::fill(out, out + lo * CN, T(0));
+                std::fill(out + hi * CN, out + dst.cols * CN, T(0));
+
+                const int16_t *sx = sx_.data() + row_offset_[y];
+                const int16_t *sy = sy_.data() + row_offset_[y];
+                const uint8_t *wx = wx_.data() + row_offset_[y];
+                const uint8_t *wy = wy_.data() + row_offset_[y];
+
+                for (int i = 0, n = hi - lo; i < n; ++i)
+                {
+                    const T *p = base + sy[i] * step + sx[i] * CN;
+                    T *o = out + (lo + i) * CN;
+                    if (nearest)
+                    {
+                        for (int c = 0; c < CN; ++c)
+                            o[c] = p[c];
+                        continue;
+                    }
+
+                    const int ax = wx[i], ay = wy[i];
+                    for (int c = 0; c < CN; ++c)
+                    {
+                        if constexpr (std::is_same_v<T, uchar>)
+                        {
+                            // 两级 8 位权重，结果落在 16 位小数上
+                            int top = p[c] * (kWeightOne - ax) + p[CN + c] * ax;
+                            int bot = p[step + c] * (kWeightOne - ax) + p[step + CN + c] * ax;
+                            o[c] = static_cast<uchar>((top * (kWeightOne - ay) + bot * ay + (1 << 15)) >> 16);
+                        }
+                        else
+                        {
+                            const double fx = ax * (1.0 / kWeightOne), fy = ay * (1.0 / kWeightOne);
+                            double top = p[c] * (1 - fx) + p[CN + c] * fx;
+                            double bot = p[step + c] * (1 - fx) + p[step + CN + c] * fx;
+                            o[c] = pixelFromDouble<T>(top * (1 - fy) + bot * fy);
+                        }
+                    }
+                }
+            } });
+    }
+
+    template <typename V>
+    static void writePod(std::ofstream &ofs, const V &v) { ofs.write(reinterpret_cast<const char *>(&v), sizeof(V)); }
+
+    template <typename V>
+    static void readPod(std::ifstream &ifs, V &v) { ifs.read(reinterpret_cast<char *>(&v), sizeof(V)); }
+
+    template <typename V>
+    static void writeVec(std::ofstream &ofs, const std::vector<V> &v)
+    {
+        uint64_t n = v.size();
+        writePod(ofs, n);
+        ofs.write(reinterpret_cast<const char *>(v.data()), static_cast<std::streamsize>(n * sizeof(V)));
+    }
+
+    template <typename V>
+    static bool readVec(std::ifstream &ifs, std::vector<V> &v)
+    {
+        uint64_t n = 0;
+        readPod(ifs, n);
+        if (!ifs || n > (uint64_t(1) << 32))
+            return false;
+        v.resize(n);
+        ifs.read(reinterpret_cast<char *>(v.data()), static_cast<std::streamsize>(n * sizeof(V)));
+        return static_cast<bool>(ifs);
+    }
+};
+
+/*
+ * @class WarpPlanCache
+ * @brief  按键缓存计划（LRU，最多常驻 capacity 个）；给定目录时先查磁盘，未命中才构建并写回
+ * @note   get 返回的引用在下一次 get 淘汰该计划之前有效；每个计划只用一次的场景（如 radon 的各个角度）取 capacity = 1，
+ *         复用靠磁盘，进程内只常驻当前计划
+ */
+class WarpPlanCache
+{
+public:
+    explicit WarpPlanCache(std::string dir = "", size_t capacity = 16) : dir_(std::move(dir)), capacity_(capacity)
+    {
+        CV_Assert(capacity_ > 0);
+        if (!dir_.empty())
+            std::filesystem::create_directories(dir_);
+    }
+
+    const WarpPlan &get(cv::Size src_size, const cv::Mat &M, cv::Size dst_size, int interp = cv::INTER_LINEAR)
+    {
+        WarpPlanKey key = myMakeWarpPlanKey(src_size, M, dst_size, interp);
+        auto it = index_.find(key);
+        if (it != index_.end())
+        {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->second;
+        }
+
+        WarpPlan plan;
+        std::string path = pathFor(key);
+        // 哈希碰撞时键不相等，按未命中处理
+        if (path.empty() || !plan.load(path) || !(plan.key() == key))
+        {
+            plan = WarpPlan::build(key);
+            if (!path.empty())
+                plan.save(path);
+        }
+        // 先淘汰再插入，常驻计划数不超过 capacity
+        while (lru_.size() >= capacity_)
+        {
+            index_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+        lru_.emplace_front(key, std::move(plan));
+        index_.emplace(key, lru_.begin());
+        return lru_.front().second;
+    }
+
+    size_t size() const { return lru_.size(); }
+
+private:
+    using Entry = std::pair<WarpPlanKey, WarpPlan>;
+
+    std::string dir_;
+    size_t capacity_;
+    std::list<Entry> lru_; // 最近使用的在前
+    std::unordered_map<WarpPlanKey, std::list<Entry>::iterator, WarpPlanKeyHash> index_;
+
+    std::string pathFor(const WarpPlanKey &key) const
+    {
+        if (dir_.empty())
+            return "";
+        std::ostringstream name;
+        name << "warp_" << std::hex << std::setw(16) << std::setfill('0') << key.hash() << ".plan";
+        return (std::filesystem::path(dir_) / name.str()).string();
+    }
+};
@@ -45,7 +45,8 @@ else
 	CFLAGS=""
 fi
 
-g++ -std=c++23 "$CPP_PATH" -o "$OUT_PATH" $CFLAGS
+# -ffp-contract=off：禁止编译器把 a*b+c 合并成 FMA，保证标量与 SIMD 路径的浮点结果逐位一致
+g++ -std=c++23 -O2 -march=native -ffp-contract=off "$CPP_PATH" -o "$OUT_PATH" $CFLAGS
 
 echo "Running: $OUT_PATH ${PROGRAM_ARGS[*]}"
 "$OUT_PATH" "${PROGRAM_ARGS[@]}"
\ No newline at end of file
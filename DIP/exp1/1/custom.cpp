@@ -4,63 +4,52 @@
 #include <filesystem>
 #include <vector>
 
+#include "../../common/resize.hpp"
+
 namespace fs = std::filesystem;
 
-// 最近邻插值（2D）
+// 最近邻插值（2D）：系数表中每个输出位置只有 1 个抽头
 cv::Mat nearestNeighborResize(const cv::Mat &src, cv::Size dstSize)
 {
-    cv::Mat dst(dstSize, src.type());
-    double scaleX = static_cast<double>(src.cols) / dstSize.width;
-    double scaleY = static_cast<double>(src.rows) / dstSize.height;
-
-    for (int y = 0; y < dstSize.height; ++y)
-    {
-        for (int x = 0; x < dstSize.width; ++x)
-        {
-            int srcX = std::clamp(static_cast<int>(std::round(x * scaleX)), 0, src.cols - 1);
-            int srcY = std::clamp(static_cast<int>(std::round(y * scaleY)), 0, src.rows - 1);
-            dst.at<uchar>(y, x) = src.at<uchar>(srcY, srcX);
-        }
-    }
-    return dst;
+    return mySeparableResize(src, dstSize, ResizeMode::Nearest);
 }
 
-// 双线性插值（2D）
+// 双线性插值（2D）：先水平后垂直的两个一维线性插值
 cv::Mat bilinearResize(const cv::Mat &src, cv::Size dstSize)
 {
-    cv::Mat dst(dstSize, src.type());
-    double scaleX = static_cast<double>(src.cols) / dstSize.width;
-    double scaleY = static_cast<double>(src.rows) / dstSize.height;
+    return mySeparableResize(src, dstSize, ResizeMode::Bilinear);
+}
+
+// 双三次插值（2D）：每个轴 4 个抽头
+cv::Mat bicubicResize(const cv::Mat &src, cv::Size dstSize)
+{
+    return mySeparableResize(src, dstSize, ResizeMode::Bicubic);
+}
+
+// Lanczos-3 插值（2D）：每个轴 6 个抽头，缩小时核按比例拉宽
+cv::Mat lanczos3Resize(const cv::Mat &src, cv::Size dstSize)
+{
+    return mySeparableResize(src, dstSize, ResizeMode::Lanczos3);
+}
+
+// 区域平均（2D）：缩小时按覆盖面积加权，抗混叠
+cv::Mat areaResize(const cv::Mat &src, cv::Size dstSize)
+{
+    return mySeparableResize(src, dstSize, ResizeMode::Area);
+}
 
-    for (int y = 0; y < dstSize.height; ++y)
+// 计时：重复 runs 次取最快的一次，返回毫秒
+template <typename F>
+double time_best_ms(F &&f, int runs = 5)
+{
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i)
     {
-        for (int x = 0; x < dstSize.width; ++x)
-        {
-            double srcX = (x + 0.5) * scaleX - 0.5;
-            double srcY = (y + 0.5) * scaleY - 0.5;
-
-            int x1 = std::clamp(static_cast<int>(std::floor(srcX)), 0, src.cols - 1);
-            int y1 = std::clamp(static_cast<int>(std::floor(srcY)), 0, src.rows - 1);
-            int x2 = std::clamp(x1 + 1, 0, src.cols - 1);
-            int y2 = std::clamp(y1 + 1, 0, src.rows - 1);
-
-            double dx = srcX - x1;
-            double dy = srcY - y1;
-
-            double f11 = src.at<uchar>(y1, x1);
-            double f12 = src.at<uchar>(y1, x2);
-            double f21 = src.at<uchar>(y2, x1);
-            double f22 = src.at<uchar>(y2, x2);
-
-            double value = f11 * (1 - dx) * (1 - dy) +
-                           f12 * dx * (1 - dy) +
-                           f21 * (1 - dx) * dy +
-                           f22 * dx * dy;
-
-            dst.at<uchar>(y, x) = static_cast<uchar>(std::round(value));
-        }
+        int64 t0 = cv::getTickCount();
+        f();
+        best = std::min(best, (cv::getTickCount() - t0) * 1000.0 / cv::getTickFrequency());
     }
-    return dst;
+    return best;
 }
 
 // 获取文件大小
@@ -80,43 +69,62 @@ int main()
         return -1;
     }
 
-    cv::Mat ez;
-    cv::resize(src, ez, cv::Size(src.cols * 2, src.rows * 2), 0, 0, cv::INTER_LINEAR);
-    cv::Mat nn = nearestNeighborResize(src, cv::Size(src.cols * 2, src.rows * 2));
-    cv::Mat bl = bilinearResize(src, cv::Size(src.cols * 2, src.rows * 2));
+    const cv::Size up(src.cols * 2, src.rows * 2);
+    const cv::Size down(src.cols / 2, src.rows / 2);
+
+    cv::Mat ez, nn, bl, bc, lz, ar;
+    double t_ez = time_best_ms([&]
+                               { cv::resize(src, ez, up, 0, 0, cv::INTER_LINEAR); });
+    double t_nn = time_best_ms([&]
+                               { nn = nearestNeighborResize(src, up); });
+    double t_bl = time_best_ms([&]
+                               { bl = bilinearResize(src, up); });
+    double t_bc = time_best_ms([&]
+                               { bc = bicubicResize(src, up); });
+    double t_lz = time_best_ms([&]
+                               { lz = lanczos3Resize(src, up); });
+    double t_ar = time_best_ms([&]
+                               { ar = areaResize(src, down); });
 
     cv::imwrite("./easy_resize.png", ez);
     cv::imwrite("./resize_nn.png", nn);
     cv::imwrite("./resize_bilinear.png", bl);
+    cv::imwrite("./resize_bicubic.png", bc);
+    cv::imwrite("./resize_lanczos3.png", lz);
+    cv::imwrite("./resize_area_half.png", ar);
 
-    std::cout << "\n================= Interpolation Comparison =================\n";
+    // 吞吐量按输出像素计算（百万像素/秒）
+    auto print_row = [](const std::string &name, const cv::Mat &img, const std::string &path, double ms)
+    {
+        std::cout << std::left << std::setw(20) << name
+                  << std::setw(10) << img.cols
+                  << std::setw(10) << img.rows
+                  << std::setw(16) << std::fixed << std::setprecision(2) << get_file_size_kb(path);
+        if (ms > 0)
+            std::cout << std::setw(12) << ms << std::setw(10) << img.total() / (ms * 1000.0);
+        else
+            std::cout << std::setw(12) << "-" << std::setw(10) << "-";
+        std::cout << "\n";
+    };
+
+    std::cout << "\n=========================== Interpolation Comparison ===========================\n";
     std::cout << std::left << std::setw(20) << "Method"
               << std::setw(10) << "Width"
               << std::setw(10) << "Height"
-              << std::setw(10) << "File Size (KB)"
-              << "\n------------------------------------------------------------\n";
-
-    std::cout << std::left << std::setw(20) << "Original"
-              << std::setw(10) << src.cols
-              << std::setw(10) << src.rows
-              << std::setw(10) << std::fixed << std::setprecision(2) << get_file_size_kb("../SEU_gray.png") << "\n";
-
-    std::cout << std::left << std::setw(20) << "OpenCV Bilinear"
-              << std::setw(10) << ez.cols
-              << std::setw(10) << ez.rows
-              << std::setw(10) << std::fixed << std::setprecision(2) << get_file_size_kb("./easy_resize.png") << "\n";
-
-    std::cout << std::left << std::setw(20) << "Nearest Neighbor"
-              << std::setw(10) << nn.cols
-              << std::setw(10) << nn.rows
-              << std::setw(10) << std::fixed << std::setprecision(2) << get_file_size_kb("./resize_nn.png") << "\n";
-
-    std::cout << std::left << std::setw(20) << "Bilinear"
-              << std::setw(10) << bl.cols
-              << std::setw(10) << bl.rows
-              << std::setw(10) << get_file_size_kb("./resize_bilinear.png") << "\n";
-
-    std::cout << "============================================================\n";
+              << std::setw(16) << "File Size (KB)"
+              << std::setw(12) << "Time (ms)"
+              << std::setw(10) << "MPix/s"
+              << "\n--------------------------------------------------------------------------------\n";
+
+    print_row("Original", src, "../SEU_gray.png", 0);
+    print_row("OpenCV Bilinear", ez, "./easy_resize.png", t_ez);
+    print_row("Nearest Neighbor", nn, "./resize_nn.png", t_nn);
+    print_row("Bilinear", bl, "./resize_bilinear.png", t_bl);
+    print_row("Bicubic", bc, "./resize_bicubic.png", t_bc);
+    print_row("Lanczos-3", lz, "./resize_lanczos3.png", t_lz);
+    print_row("Area (0.5x)", ar, "./resize_area_half.png", t_ar);
+
+    std::cout << "================================================================================\n";
 
     return 0;
 }
@@ -5,75 +5,22 @@
 
 #include <cmath>
 
-namespace fs = std::filesystem;
+#include "../../common/transform.hpp"
 
-/*
- * @function myGetMoveMatrix
- * @brief  生成平移变换的齐次 3x3 矩阵
- * @param  tx x 方向平移
- * @param  ty y 方向平移
- * @return     3x3 齐次变换矩阵
- */
-cv::Mat myGetMoveMatrix(double tx, double ty)
-{
-    cv::Mat move_mat = (cv::Mat_<double>(3, 3) << 1, 0, tx,
-                        0, 1, ty,
-                        0, 0, 1);
-    return move_mat;
-}
+namespace fs = std::filesystem;
 
 /*
  * @function myMove
- * @brief  使用逆映射和双线性插值执行平移变换
+ * @brief  平移变换
  * @param  src 输入图像
- * @param  tx  x 方向平移（可以为负）
- * @param  ty  y 方向平移（可以为负）
+ * @param  tx  x 方向平移（可以为负，可以是小数）
+ * @param  ty  y 方向平移（可以为负，可以是小数）
  * @return     变换后的图像
+ * @note 平移不需要逐像素的矩阵乘法：整数偏移逐行 memcpy，小数偏移用固定权重的两抽头水平 + 垂直混合
  */
 cv::Mat myMove(const cv::Mat &src, double tx, double ty)
 {
-    cv::Mat move_mat = myGetMoveMatrix(tx, ty);
-    cv::Mat inv_move = move_mat.inv();
-
-    cv::Mat dst(src.rows, src.cols, src.type(), cv::Scalar(0));
-
-    for (int y = 0; y < dst.rows; ++y)
-    {
-        for (int x = 0; x < dst.cols; ++x)
-        {
-            double srcX = inv_move.at<double>(0, 0) * x +
-                          inv_move.at<double>(0, 1) * y +
-                          inv_move.at<double>(0, 2);
-            double srcY = inv_move.at<double>(1, 0) * x +
-                          inv_move.at<double>(1, 1) * y +
-                          inv_move.at<double>(1, 2);
-
-            if (srcX < 0 || srcX >= src.cols - 1 || srcY < 0 || srcY >= src.rows - 1)
-                continue;
-
-            int x1 = std::clamp(static_cast<int>(std::floor(srcX)), 0, src.cols - 1);
-            int y1 = std::clamp(static_cast<int>(std::floor(srcY)), 0, src.rows - 1);
-            int x2 = std::clamp(x1 + 1, 0, src.cols - 1);
-            int y2 = std::clamp(y1 + 1, 0, src.rows - 1);
-
-            double dx = srcX - x1;
-            double dy = srcY - y1;
-
-            double f11 = src.at<uchar>(y1, x1);
-            double f12 = src.at<uchar>(y1, x2);
-            double f21 = src.at<uchar>(y2, x1);
-            double f22 = src.at<uchar>(y2, x2);
-
-            double value = f11 * (1 - dx) * (1 - dy) +
-                           f12 * dx * (1 - dy) +
-                           f21 * (1 - dx) * dy +
-                           f22 * dx * dy;
-
-            dst.at<uchar>(y, x) = static_cast<uchar>(std::round(value));
-        }
-    }
-
-    return dst;
+    return myTranslate(src, tx, ty, src.size());
 }
 
 int main(int argc, char **argv)
@@ -130,8 +77,11 @@ int main(int argc, char **argv)
     dst_path = "./easy_move_inv.png";
     cv::imwrite(dst_path, dst_inv);
 
-    // 5.2 使用自定义函数进行逆变换
-    cv::Mat dst_custom_inv = myMove(dst_custom, -move_x, -move_y);
+    // 5.2 自定义逆变换：正、逆平移合成一条链，只对原图重采样一次
+    //     两者抵消为单位阵时直接拷贝；合成为整数平移时逐行 memcpy
+    TransformChain chain;
+    chain.move(move_x, move_y).move(-move_x, -move_y);
+    cv::Mat dst_custom_inv = chain.apply(src);
     dst_path = "./custom_move_inv.png";
     cv::imwrite(dst_path, dst_custom_inv);
 
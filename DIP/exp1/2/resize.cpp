@@ -5,22 +5,9 @@
 
 #include <cmath>
 
-namespace fs = std::filesystem;
+#include "../../common/transform.hpp"
 
-/*
- * @function myGetMoveMatrix
- * @brief  生成缩放变换的齐次 3x3 矩阵
- * @param  scale_x x 方向缩放
- * @param  scale_y y 方向缩放
- * @return     3x3 齐次变换矩阵
- */
-cv::Mat myGetMoveMatrix(double scale_x, double scale_y)
-{
-    cv::Mat move_mat = (cv::Mat_<double>(3, 3) << scale_x, 0, 0,
-                        0, scale_y, 0,
-                        0, 0, 1);
-    return move_mat;
-}
+namespace fs = std::filesystem;
 
 /*
  * @function myResize
@@ -33,52 +20,10 @@ cv::Mat myGetMoveMatrix(double scale_x, double scale_y)
  */
 cv::Mat myResize(const cv::Mat &src, double scale_x, double scale_y)
 {
-    cv::Mat scale_mat = myGetMoveMatrix(scale_x, scale_y);
-    cv::Mat inv_scale = scale_mat.inv();
+    cv::Mat scale_mat = myGetScaleMatrix(scale_x, scale_y);
 
     // 将输出 dst 的尺寸设置为原始图像尺寸，超出的部分隐式丢弃
-    int dst_w = src.cols;
-    int dst_h = src.rows;
-
-    cv::Mat dst(dst_h, dst_w, src.type(), cv::Scalar(0));
-
-    for (int y = 0; y < dst_h; ++y)
-    {
-        for (int x = 0; x < dst_w; ++x)
-        {
-            double srcX = inv_scale.at<double>(0, 0) * x +
-                          inv_scale.at<double>(0, 1) * y +
-                          inv_scale.at<double>(0, 2);
-            double srcY = inv_scale.at<double>(1, 0) * x +
-                          inv_scale.at<double>(1, 1) * y +
-                          inv_scale.at<double>(1, 2);
-
-            if (srcX < 0 || srcX >= src.cols - 1 || srcY < 0 || srcY >= src.rows - 1)
-                continue;
-
-            int x1 = std::clamp(static_cast<int>(std::floor(srcX)), 0, src.cols - 1);
-            int y1 = std::clamp(static_cast<int>(std::floor(srcY)), 0, src.rows - 1);
-            int x2 = std::clamp(x1 + 1, 0, src.cols - 1);
-            int y2 = std::clamp(y1 + 1, 0, src.rows - 1);
-
-            double dx = srcX - x1;
-            double dy = srcY - y1;
-
-            double f11 = src.at<uchar>(y1, x1);
-            double f12 = src.at<uchar>(y1, x2);
-            double f21 = src.at<uchar>(y2, x1);
-            double f22 = src.at<uchar>(y2, x2);
-
-            double value = f11 * (1 - dx) * (1 - dy) +
-                           f12 * dx * (1 - dy) +
-                           f21 * (1 - dx) * dy +
-                           f22 * dx * dy;
-
-            dst.at<uchar>(y, x) = static_cast<uchar>(std::round(value));
-        }
-    }
-
-    return dst;
+    return myWarpAffine(src, scale_mat, src.size());
 }
 
 int main(int argc, char **argv)
@@ -139,9 +84,11 @@ int main(int argc, char **argv)
     std::string dst_path = "./easy_resize_inv.png";
     cv::imwrite(dst_path, easy_inv);
 
-    // 5.2 使用自定义函数进行逆变换（缩放的逆为 1/scale）
-    cv::Mat dst_inv_custom;
-    dst_inv_custom = myResize(dst_custom_cropped, 1.0 / scale_x, 1.0 / scale_y);
+    // 5.2 自定义逆变换：缩放与逆缩放（1/scale）合成一条链，只对原图重采样一次
+    //     两者抵消为单位阵时直接拷贝，不再经过两次插值
+    TransformChain chain;
+    chain.scale(scale_x, scale_y).scale(1.0 / scale_x, 1.0 / scale_y);
+    cv::Mat dst_inv_custom = chain.apply(src);
     dst_path = "./custom_resize_inv.png";
     cv::imwrite(dst_path, dst_inv_custom);
     return 0;
@@ -3,34 +3,10 @@
 #include <iomanip>
 #include <filesystem>
 
-namespace fs = std::filesystem;
-
-/*
- * @function myGetRotationMatrix2D
- * @brief  自定义计算旋转矩阵的函数
- * @param  center 旋转中心
- * @param  angle  旋转角度（逆时针，单位：度）
- * @return        3x3 的旋转矩阵
- * @note OpenCV 的 getRotationMatrix2D 返回的是 2x3 矩阵，这里为了方便学习理解，返回一个完整的 3x3 矩阵
- */
-cv::Mat myGetRotationMatrix2D(cv::Point2f center, double angle)
-{
-    double alpha = std::cos(angle * CV_PI / 180.0);
-    double beta = std::sin(angle * CV_PI / 180.0);
-
-    cv::Mat rot_mat(3, 3, CV_64F);
-    rot_mat.at<double>(0, 0) = alpha;
-    rot_mat.at<double>(0, 1) = beta;
-    rot_mat.at<double>(0, 2) = (1 - alpha) * center.x - beta * center.y;
-    rot_mat.at<double>(1, 0) = -beta;
-    rot_mat.at<double>(1, 1) = alpha;
-    rot_mat.at<double>(1, 2) = beta * center.x + (1 - alpha) * center.y;
-    rot_mat.at<double>(2, 0) = 0.0;
-    rot_mat.at<double>(2, 1) = 0.0;
-    rot_mat.at<double>(2, 2) = 1.0;
+#include "../../common/shear_rotate.hpp"
+#include "../../common/transform.hpp"
 
-    return rot_mat;
-}
+namespace fs = std::filesystem;
 
 /*
  * @function myRotate
@@ -38,7 +14,7 @@ cv::Mat myGetRotationMatrix2D(cv::Point2f center, double angle)
  * @param  src          输入图像
  * @param  rotate_angle 旋转角度（逆时针，单位：度）
  * @return              旋转后的图像
- * @note 使用双线性插值法进行插值
+ * @note 使用双线性插值法进行插值，源图像范围外的像素填 0
  */
 cv::Mat myRotate(const cv::Mat &src, int rotate_angle)
 {
@@ -46,43 +22,21 @@ cv::Mat myRotate(const cv::Mat &src, int rotate_angle)
     cv::Point2f center(src.cols / 2.0f, src.rows / 2.0f);
     cv::Mat rot_mat = myGetRotationMatrix2D(center, rotate_angle);
 
-    // 创建目标图像
-    cv::Mat dst = cv::Mat::zeros(src.rows, src.cols, src.type());
-
-    // 遍历目标图像的每个像素
-    for (int y = 0; y < dst.rows; ++y)
-    {
-        for (int x = 0; x < dst.cols; ++x)
-        {
-            // 计算源图像中的对应位置
-            cv::Mat inv_rot = rot_mat.inv();
-            double srcX = inv_rot.at<double>(0, 0) * x + inv_rot.at<double>(0, 1) * y + inv_rot.at<double>(0, 2);
-            double srcY = inv_rot.at<double>(1, 0) * x + inv_rot.at<double>(1, 1) * y + inv_rot.at<double>(1, 2);
-
-            // 双线性插值
-            int x1 = std::clamp(static_cast<int>(std::floor(srcX)), 0, src.cols - 1);
-            int y1 = std::clamp(static_cast<int>(std::floor(srcY)), 0, src.rows - 1);
-            int x2 = std::clamp(x1 + 1, 0, src.cols - 1);
-            int y2 = std::clamp(y1 + 1, 0, src.rows - 1);
-
-            double dx = srcX - x1;
-            double dy = srcY - y1;
-
-            double f11 = src.at<uchar>(y1, x1);
-            double f12 = src.at<uchar>(y1, x2);
-            double f21 = src.at<uchar>(y2, x1);
-            double f22 = src.at<uchar>(y2, x2);
-
-            double value = f11 * (1 - dx) * (1 - dy) +
-                           f12 * dx * (1 - dy) +
-                           f21 * (1 - dx) * dy +
-                           f22 * dx * dy;
-
-            dst.at<uchar>(y, x) = static_cast<uchar>(std::round(value));
-        }
-    }
+    // 逆矩阵只求一次，逐行插值交给共用的仿射引擎
+    return myWarpAffine(src, rot_mat, src.size());
+}
 
-    return dst;
+/*
+ * @function myRotateShear
+ * @brief  三次剪切旋转（Paeth）：x 剪切 -> y 剪切 -> x 剪切，每趟都是连续内存上的一维插值
+ * @param  src          输入图像
+ * @param  rotate_angle 旋转角度（逆时针，单位：度）
+ * @return              旋转后的图像，与 myRotate 的中心、尺寸约定相同
+ */
+cv::Mat myRotateShear(const cv::Mat &src, int rotate_angle)
+{
+    cv::Point2f center(src.cols / 2.0f, src.rows / 2.0f);
+    return myRotateThreeShear(src, rotate_angle, center, src.size());
 }
 
 int main(int argc, char **argv)
@@ -110,14 +64,17 @@ int main(int argc, char **argv)
     cv::Mat rot_mat = cv::getRotationMatrix2D(center, rotate_angle, 1.0);
     cv::warpAffine(src, dst, rot_mat, dst.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0));
 
-    // 3. 使用自定义的旋转函数
+    // 3. 使用自定义的旋转函数（二维双线性 / 三次剪切）
     cv::Mat dst_custom = myRotate(src, rotate_angle);
+    cv::Mat dst_shear = myRotateShear(src, rotate_angle);
 
     // 4. 保存旋转后的图像
     std::string dst_path = "./easy_rotate.png";
     cv::imwrite(dst_path, dst);
     dst_path = "./custom_rotate.png";
     cv::imwrite(dst_path, dst_custom);
+    dst_path = "./custom_rotate_3shear.png";
+    cv::imwrite(dst_path, dst_shear);
 
     // 5. 对变换后的图像进行逆变换并保存
     // 5.1 使用 OpenCV 的函数进行逆变换
@@ -128,8 +85,11 @@ int main(int argc, char **argv)
     std::string recovered_path = "./easy_rotate_inv.png";
     cv::imwrite(recovered_path, recovered);
 
-    // 5.2 使用自定义的旋转函数进行逆变换
-    cv::Mat inv_dst_custom = myRotate(dst_custom, -rotate_angle);
+    // 5.2 自定义逆变换：正、逆旋转合成一条链，只对原图重采样一次
+    //     两者抵消为单位阵时直接拷贝，不再经过两次插值
+    TransformChain chain;
+    chain.rotate(center, rotate_angle).rotate(center, -rotate_angle);
+    cv::Mat inv_dst_custom = chain.apply(src);
     recovered_path = "./custom_rotate_inv.png";
     cv::imwrite(recovered_path, inv_dst_custom);
 
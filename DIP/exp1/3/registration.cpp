@@ -1,12 +1,429 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/features2d.hpp>
-#include <opencv2/calib3d.hpp>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#include "../../common/feature_store.hpp"
+#include "../../common/hamming.hpp"
+#include "../../common/homography.hpp"
+#include "../../common/track.hpp"
+#include "../../common/warp.hpp"
+
+namespace fs = std::filesystem;
+
+// 参考图像的关键点 / 描述子持久化到磁盘并 mmap 读取：同一参考图只检测一次。
+// 参数检查通过后才创建存储目录；目录无法创建时给出提示，而不是在 main 之前异常终止
+static std::optional<FeatureStore> openFeatureStore()
+{
+    try
+    {
+        return std::optional<FeatureStore>(std::in_place, "./feature_store");
+    }
+    catch (const fs::filesystem_error &e)
+    {
+        std::cerr << "❌ 无法创建特征存储目录：" << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+/*
+ * @function estimateAlignment
+ * @brief  由匹配点估计把 moving 图像对齐到参考图像的单应矩阵
+ * @param  k_ref  参考图像关键点（匹配中的 queryIdx）
+ * @param  k_mov  待配准图像关键点（匹配中的 trainIdx）
+ * @param  good   匹配
+ * @param  ratios 每个匹配的比率测试分数 d1/d2（PROSAC 排序用，可为空）
+ * @param  stats  估计统计（迭代次数、SPRT 拒绝数、内点数、耗时）
+ * @param  mask   可选输出：每个匹配是否为内点
+ * @return        3x3 单应矩阵，失败时为空
+ */
+static cv::Mat estimateAlignment(const std::vector<cv::KeyPoint> &k_ref, const std::vector<cv::KeyPoint> &k_mov,
+                                 const std::vector<cv::DMatch> &good, const std::vector<float> &ratios,
+                                 HomographyStats &stats, std::vector<uchar> *mask = nullptr)
+{
+    std::vector<cv::Point2f> p1, p2;
+    for (auto &m : good)
+    {
+        p1.push_back(k_ref[m.queryIdx].pt);
+        p2.push_back(k_mov[m.trainIdx].pt);
+    }
+    return myFindHomographyRobust(p2, p1, ratios, mask, &stats);
+}
+
+// 目录中的图像文件，按文件名排序（序列模式下即帧顺序）
+static std::vector<fs::path> listImages(const std::string &dir)
+{
+    std::vector<fs::path> files;
+    for (const auto &e : fs::directory_iterator(dir))
+    {
+        std::string ext = e.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (e.is_regular_file() && (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tif" || ext == ".tiff"))
+            files.push_back(e.path());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+/*
+ * @struct BatchReference
+ * @brief  批量模式的一张参考图像及其（从存储映射的）特征
+ */
+struct BatchReference
+{
+    fs::path path;
+    cv::Mat img;
+    std::shared_ptr<const MappedFeatures> feat; // 保持映射，descriptors 指向其中
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+};
+
+/*
+ * @function runBatch
+ * @brief  批量模式：把目录中的所有图像配准到参考图像（单张，或一个目录中的多张，每张待配准图像选匹配最多的那张）
+ * @param  ref_path 参考图像，或参考图像所在目录
+ * @param  in_dir   待配准图像所在目录
+ * @param  out_dir  输出目录，每张图写出 <文件名>_aligned.png
+ * @param  use_lsh  true 时所有参考描述子建一个多探针 LSH 索引，每张待配准图像只查询一次；
+ *                  否则对每张参考图像做分块暴力匹配
+ * @param  store    参考特征存储
+ * @note   参考特征从存储中映射（首次运行时检测并写入），每张待配准图像只检测一次
+ */
+static int runBatch(const std::string &ref_path, const std::string &in_dir, const std::string &out_dir, bool use_lsh,
+                    FeatureStore &store)
+{
+    std::vector<fs::path> ref_files = fs::is_directory(ref_path) ? listImages(ref_path) : std::vector<fs::path>{ref_path};
+    std::vector<BatchReference> refs;
+    for (const auto &f : ref_files)
+    {
+        BatchReference r;
+        r.path = f;
+        r.img = cv::imread(f.string(), cv::IMREAD_GRAYSCALE);
+        if (r.img.empty())
+        {
+            std::cerr << "❌ 无法读取参考图像：" << f << std::endl;
+            return -1;
+        }
+        r.feat = store.get(r.img);
+        if (!r.feat || r.feat->count() < 4)
+        {
+            std::cerr << "❌ 参考图像特征提取失败！" << f << std::endl;
+            return -1;
+        }
+        std::cout << "参考特征：" << f.filename().string() << "，" << r.feat->count() << " 个关键点（"
+                  << (store.lastWasHit() ? "从存储加载" : "新检测并写入存储") << "）" << std::endl;
+        r.keypoints = r.feat->keypoints();
+        r.descriptors = r.feat->descriptors();
+        refs.push_back(std::move(r));
+    }
+    if (refs.empty())
+    {
+        std::cerr << "❌ 没有参考图像：" << ref_path << std::endl;
+        return -1;
+    }
+
+    HammingLshIndex index;
+    if (use_lsh)
+    {
+        for (const auto &r : refs)
+            index.add(r.descriptors);
+        index.build();
+        std::cout << "LSH 索引：" << index.images() << " 张参考图像，" << index.size() << " 个描述子" << std::endl;
+    }
+
+    std::vector<fs::path> files = listImages(in_dir);
+    fs::create_directories(out_dir);
+
+    auto orb = store.params().create();
+    int ok = 0;
+    double total_ms = 0;
+    for (const auto &f : files)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        cv::Mat mov = cv::imread(f.string(), cv::IMREAD_GRAYSCALE);
+        if (mov.empty())
+        {
+            std::cerr << "跳过（无法读取）：" << f << std::endl;
+            continue;
+        }
+
+        std::vector<cv::KeyPoint> k_mov;
+        cv::Mat d_mov;
+        orb->detectAndCompute(mov, cv::noArray(), k_mov, d_mov);
+
+        // 匹配：queryIdx 为参考关键点，trainIdx 为待配准关键点；选通过比率测试的匹配最多的参考图像
+        int best = 0;
+        std::vector<float> ratios;
+        std::vector<cv::DMatch> good;
+        if (!d_mov.empty() && use_lsh)
+        {
+            // 索引里是参考描述子，由待配准图像查询，结果按参考图像分组后交换 query / train
+            std::vector<float> r;
+            std::vector<cv::DMatch> all = index.match(d_mov, 0.75f, -1, &r);
+            std::vector<int> votes(refs.size(), 0);
+            for (const auto &m : all)
+                ++votes[m.imgIdx];
+            best = static_cast<int>(std::max_element(votes.begin(), votes.end()) - votes.begin());
+            for (size_t i = 0; i < all.size(); ++i)
+                if (all[i].imgIdx == best)
+                {
+                    good.emplace_back(all[i].trainIdx, all[i].queryIdx, all[i].distance);
+                    ratios.push_back(r[i]);
+                }
+        }
+        else if (!d_mov.empty())
+        {
+            for (size_t i = 0; i < refs.size(); ++i)
+            {
+                std::vector<float> r;
+                std::vector<cv::DMatch> g = myHammingRatioMatch(refs[i].descriptors, d_mov, 0.75f, &r);
+                if (i == 0 || g.size() > good.size())
+                {
+                    best = static_cast<int>(i);
+                    good = std::move(g);
+                    ratios = std::move(r);
+                }
+            }
+        }
+        const BatchReference &ref = refs[best];
+
+        HomographyStats hs;
+        cv::Mat H = good.size() >= 4 ? estimateAlignment(ref.keypoints, k_mov, good, ratios, hs) : cv::Mat();
+        if (H.empty())
+        {
+            std::cerr << "跳过（匹配不足或估计失败）：" << f << std::endl;
+            continue;
+        }
+
+        cv::Mat aligned = myWarpPerspective(mov, H, ref.img.size());
+        cv::imwrite((fs::path(out_dir) / (f.stem().string() + "_aligned.png")).string(), aligned);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        total_ms += ms;
+        ++ok;
+        std::cout << f.filename().string() << "：";
+        if (refs.size() > 1)
+            std::cout << "参考 " << ref.path.filename().string() << "，";
+        std::cout << good.size() << " 个匹配，" << hs.inliers << " 个内点，"
+                  << hs.iterations << " 次采样，" << ms << " ms" << std::endl;
+    }
+
+    std::cout << "✅ 完成 " << ok << " / " << files.size() << " 张";
+    if (ok > 0)
+        std::cout << "，平均 " << total_ms / ok << " ms/张";
+    std::cout << "，输出目录：" << out_dir << std::endl;
+    return 0;
+}
+
+/*
+ * @function runSequence
+ * @brief  序列模式：视频帧 / 切片序列逐帧配准到同一张参考图像
+ * @param  ref_path 参考图像
+ * @param  in_dir   帧所在目录（按文件名排序）
+ * @param  out_dir  输出目录，每帧写出 <文件名>_aligned.png
+ * @param  store    参考特征存储
+ * @note   相邻帧差别很小，每帧从上一帧的结果出发：上一帧的内点（与参考图像中的点一一对应）
+ *         用金字塔 LK 在当前帧中跟踪，初始位置按上一帧的帧间运动预测，跟踪点直接与参考点估计单应。
+ *         只有跟踪失败、内点比例下降或剩余跟踪点太少时，才对当前帧重新做 ORB 检测 + 匹配并重新播种。
+ */
+static int runSequence(const std::string &ref_path, const std::string &in_dir, const std::string &out_dir,
+                       FeatureStore &store)
+{
+    constexpr int kLevels = 4;              // 金字塔层数（含原图）
+    constexpr int kMinTracks = 40;          // 跟踪内点少于此数时重新检测
+    constexpr double kMinInlierRatio = 0.6; // 跟踪点中内点比例的下限
+    constexpr double kMinKeepRatio = 0.5;   // 剩余跟踪点相对播种时数量的下限
+
+    cv::Mat ref = cv::imread(ref_path, cv::IMREAD_GRAYSCALE);
+    if (ref.empty())
+    {
+        std::cerr << "❌ 无法读取参考图像：" << ref_path << std::endl;
+        return -1;
+    }
+    auto ref_feat = store.get(ref);
+    if (!ref_feat || ref_feat->count() < 4)
+    {
+        std::cerr << "❌ 参考图像特征提取失败！" << std::endl;
+        return -1;
+    }
+    const std::vector<cv::KeyPoint> k_ref = ref_feat->keypoints();
+    const cv::Mat d_ref = ref_feat->descriptors();
+
+    std::vector<fs::path> files = listImages(in_dir);
+    fs::create_directories(out_dir);
+    auto orb = store.params().create();
+
+    // 跟踪状态：上一帧的金字塔、上一帧中的跟踪点及其在参考图像中的对应点
+    TrackPyramid prev_pyr, cur_pyr;
+    std::vector<cv::Point2f> prev_pts, ref_pts;
+    size_t seeded = 0;
+    cv::Mat H_prev, motion; // 上一帧 -> 参考；上一帧的帧间运动（前一帧 -> 上一帧）
+
+    int n_tracked = 0, n_detected = 0;
+    double ms_tracked = 0, ms_detected = 0;
+    for (const auto &f : files)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        cv::Mat frame = cv::imread(f.string(), cv::IMREAD_GRAYSCALE);
+        if (frame.empty())
+        {
+            std::cerr << "跳过（无法读取）：" << f << std::endl;
+            continue;
+        }
+        if (!prev_pyr.img.empty() && prev_pyr.img[0].size() != frame.size())
+            prev_pts.clear(); // 帧尺寸变化，无法跟踪
+        cur_pyr.build(frame, kLevels);
+
+        // 1. 跟踪：上一帧的点 -> 当前帧，与参考点直接估计单应
+        cv::Mat H;
+        HomographyStats hs;
+        std::vector<cv::Point2f> cur_pts, src, dst;
+        std::vector<float> err, scores;
+        std::vector<uchar> status, mask;
+        size_t tracked = 0;
+        if (!prev_pts.empty())
+        {
+            if (!motion.empty())
+                cv::perspectiveTransform(prev_pts, cur_pts, motion);
+            myTrackPoints(prev_pyr, cur_pyr, prev_pts, cur_pts, status, err);
+            for (size_t i = 0; i < prev_pts.size(); ++i)
+                if (status[i])
+                {
+                    src.push_back(cur_pts[i]);
+                    dst.push_back(ref_pts[i]);
+                    scores.push_back(err[i]);
+                }
+            tracked = src.size();
+            if (static_cast<int>(tracked) >= kMinTracks)
+                H = myFindHomographyRobust(src, dst, scores, &mask, &hs);
+            if (!H.empty() && (hs.inliers < kMinTracks || hs.inliers < kMinInlierRatio * tracked ||
+                               hs.inliers < kMinKeepRatio * seeded))
+                H.release();
+        }
+
+        const bool by_tracking = !H.empty();
+        if (by_tracking)
+        {
+            // 只保留内点继续跟踪
+            prev_pts.clear();
+            ref_pts.clear();
+            for (size_t i = 0; i < src.size(); ++i)
+                if (mask[i])
+                {
+                    prev_pts.push_back(src[i]);
+                    ref_pts.push_back(dst[i]);
+                }
+        }
+        else
+        {
+            // 2. 跟踪质量不足：完整的 ORB 检测 + 匹配，用内点重新播种
+            std::vector<cv::KeyPoint> k_mov;
+            cv::Mat d_mov;
+            orb->detectAndCompute(frame, cv::noArray(), k_mov, d_mov);
+            std::vector<float> ratios;
+            std::vector<cv::DMatch> good;
+            if (!d_mov.empty())
+                good = myHammingRatioMatch(d_ref, d_mov, 0.75f, &ratios);
+            hs = HomographyStats();
+            mask.clear();
+            if (good.size() >= 4)
+                H = estimateAlignment(k_ref, k_mov, good, ratios, hs, &mask);
+
+            prev_pts.clear();
+            ref_pts.clear();
+            if (!H.empty())
+                for (size_t i = 0; i < good.size(); ++i)
+                    if (mask[i])
+                    {
+                        prev_pts.push_back(k_mov[good[i].trainIdx].pt);
+                        ref_pts.push_back(k_ref[good[i].queryIdx].pt);
+                    }
+            seeded = prev_pts.size();
+        }
+
+        if (H.empty())
+        {
+            std::cerr << "跳过（跟踪与重新检测均失败）：" << f << std::endl;
+            motion.release();
+            H_prev.release();
+            continue;
+        }
+        // 帧间运动 = 当前帧 <- 参考 <- 上一帧，作为下一帧跟踪的初始预测
+        motion = H_prev.empty() ? cv::Mat() : H.inv() * H_prev;
+        H_prev = H;
+        std::swap(prev_pyr, cur_pyr);
+
+        cv::Mat aligned = myWarpPerspective(frame, H, ref.size());
+        cv::imwrite((fs::path(out_dir) / (f.stem().string() + "_aligned.png")).string(), aligned);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (by_tracking)
+        {
+            ++n_tracked;
+            ms_tracked += ms;
+            std::cout << f.filename().string() << "：跟踪 " << tracked << " 个点，" << hs.inliers << " 个内点，"
+                      << ms << " ms" << std::endl;
+        }
+        else
+        {
+            ++n_detected;
+            ms_detected += ms;
+            std::cout << f.filename().string() << "：重新检测，" << hs.inliers << " 个内点（播种 " << seeded
+                      << " 个跟踪点），" << ms << " ms" << std::endl;
+        }
+    }
+
+    std::cout << "✅ 完成 " << n_tracked + n_detected << " / " << files.size() << " 帧：跟踪 " << n_tracked << " 帧";
+    if (n_tracked > 0)
+        std::cout << "（平均 " << ms_tracked / n_tracked << " ms）";
+    std::cout << "，重新检测 " << n_detected << " 帧";
+    if (n_detected > 0)
+        std::cout << "（平均 " << ms_detected / n_detected << " ms）";
+    std::cout << "，输出目录：" << out_dir << std::endl;
+    return 0;
+}
 
 int main(int argc, char **argv)
 {
+    // 批量模式：./registration --batch ref.png|ref_dir moving_dir [out_dir] [--lsh]
+    if (argc >= 2 && std::string(argv[1]) == "--batch")
+    {
+        std::vector<std::string> args;
+        bool use_lsh = false;
+        for (int i = 2; i < argc; ++i)
+        {
+            if (std::string(argv[i]) == "--lsh")
+                use_lsh = true;
+            else
+                args.push_back(argv[i]);
+        }
+        if (args.size() < 2)
+        {
+            std::cerr << "用法：" << argv[0] << " --batch ref.png|ref_dir moving_dir [out_dir] [--lsh]" << std::endl;
+            return -1;
+        }
+        auto store = openFeatureStore();
+        if (!store)
+            return -1;
+        return runBatch(args[0], args[1], args.size() >= 3 ? args[2] : "./aligned", use_lsh, *store);
+    }
+    // 序列模式：./registration --sequence ref.png frames_dir [out_dir]
+    if (argc >= 2 && std::string(argv[1]) == "--sequence")
+    {
+        if (argc < 4)
+        {
+            std::cerr << "用法：" << argv[0] << " --sequence ref.png frames_dir [out_dir]" << std::endl;
+            return -1;
+        }
+        auto store = openFeatureStore();
+        if (!store)
+            return -1;
+        return runSequence(argv[2], argv[3], argc >= 5 ? argv[4] : "./aligned", *store);
+    }
 
     std::string img1_path = "../SEU_gray.png";
     std::string img2_path = "../2/custom_shear.png";
@@ -31,13 +448,22 @@ int main(int argc, char **argv)
     }
 
     // === Step 2. 提取 ORB 特征点（如果没有提供匹配文件） ===
-    auto orb = cv::ORB::create(1000);
+    // 参考图（img1）的特征从存储中映射，只有 img2 需要检测
+    auto store = openFeatureStore();
+    if (!store)
+        return -1;
     std::vector<cv::KeyPoint> k1, k2;
     cv::Mat d1, d2;
-    orb->detectAndCompute(img1, cv::noArray(), k1, d1);
-    orb->detectAndCompute(img2, cv::noArray(), k2, d2);
+    auto ref_feat = store->get(img1);
+    if (ref_feat)
+    {
+        k1 = ref_feat->keypoints();
+        d1 = ref_feat->descriptors();
+    }
+    store->params().create()->detectAndCompute(img2, cv::noArray(), k2, d2);
 
     std::vector<cv::DMatch> good;
+    std::vector<float> ratios;
     bool use_matches_file = !matches_path.empty();
 
     if (!use_matches_file)
@@ -48,18 +474,9 @@ int main(int argc, char **argv)
             return -1;
         }
 
-        // === Step 3. 特征匹配（KNN + 比率测试）===
-        cv::BFMatcher matcher(cv::NORM_HAMMING);
-        std::vector<std::vector<cv::DMatch>> knn_matches;
-        matcher.knnMatch(d1, d2, knn_matches, 2);
-
-        for (auto &m : knn_matches)
-        {
-            if (m.size() < 2)
-                continue;
-            if (m[0].distance < 0.75 * m[1].distance)
-                good.push_back(m[0]);
-        }
+        // === Step 3. 特征匹配（2-NN + 比率测试）===
+        // 分块 POPCNT/AVX2 汉明距离，比率测试在同一遍中完成，结果与 BFMatcher knnMatch(k=2) 相同
+        good = myHammingRatioMatch(d1, d2, 0.75f, &ratios);
     }
     else
     {
@@ -118,14 +535,13 @@ int main(int argc, char **argv)
     cv::imwrite("matches.png", match_img);
 
     // === Step 5. 估计单应矩阵并变换 ===
-    std::vector<cv::Point2f> p1, p2;
-    for (auto &m : good)
-    {
-        p1.push_back(k1[m.queryIdx].pt);
-        p2.push_back(k2[m.trainIdx].pt);
-    }
-
-    cv::Mat H = cv::findHomography(p2, p1, cv::RANSAC);
+    // PROSAC 按比率测试分数排序采样，SPRT 提前拒绝坏假设；匹配来自文件时没有分数，按文件顺序
+    HomographyStats hs;
+    cv::Mat H = estimateAlignment(k1, k2, good, ratios, hs);
+    std::cout << "鲁棒估计：" << hs.iterations << " 次采样，" << hs.models << " 个模型（SPRT 提前拒绝 "
+              << hs.sprt_rejected << " 个，平均每个模型验证 "
+              << (hs.models > 0 ? static_cast<double>(hs.verified) / hs.models : 0.0) << " / " << good.size()
+              << " 个点），" << hs.inliers << " / " << good.size() << " 个内点，" << hs.elapsed_ms << " ms" << std::endl;
     if (H.empty())
     {
         std::cerr << "❌ 单应矩阵估计失败！" << std::endl;
@@ -135,24 +551,28 @@ int main(int argc, char **argv)
     std::cout << "估计的单应矩阵：\n"
               << H << std::endl;
 
-    cv::Mat img2_aligned;
-    cv::warpPerspective(img2, img2_aligned, H, img1.size());
+    // === Step 6. 配准 + 叠加对比图 ===
+    // 配准结果直接写进并排图的右半边；每个输出块写完后（仍在缓存中）顺手生成叠加图并拷贝左半边的原图，
+    // 不再需要单独的 addWeighted 和两次 copyTo 遍历
+    cv::Mat aligned_display(img1.rows, img1.cols * 2, img1.type());
+    cv::Mat img2_aligned = aligned_display(cv::Rect(img1.cols, 0, img1.cols, img1.rows));
+    cv::Mat overlay(img1.size(), img1.type());
 
-    // === Step 6. 叠加对比图 ===
-    cv::Mat overlay;
-    cv::addWeighted(img1, 0.5, img2_aligned, 0.5, 0, overlay);
-    // 将原图和配准后的图并排放入一张图中，输出为 aligned_image.png
-    int rows = std::max(img1.rows, img2_aligned.rows);
-    int cols = img1.cols + img2_aligned.cols;
-    cv::Mat aligned_display(rows, cols, img1.type(), cv::Scalar::all(0));
-
-    // 拷贝原图到左边
-    cv::Mat left_roi = aligned_display(cv::Rect(0, 0, img1.cols, img1.rows));
-    img1.copyTo(left_roi);
-
-    // 拷贝配准后图到右边
-    cv::Mat right_roi = aligned_display(cv::Rect(img1.cols, 0, img2_aligned.cols, img2_aligned.rows));
-    img2_aligned.copyTo(right_roi);
+    myWarpPerspectiveTiled(img2, H, img2_aligned, [&](const cv::Rect &tile)
+                           {
+        for (int y = tile.y; y < tile.y + tile.height; ++y)
+        {
+            const uchar *a = img1.ptr<uchar>(y) + tile.x;
+            const uchar *b = img2_aligned.ptr<uchar>(y) + tile.x;
+            uchar *o = overlay.ptr<uchar>(y) + tile.x;
+            std::memcpy(aligned_display.ptr<uchar>(y) + tile.x, a, tile.width);
+            // 0.5*a + 0.5*b，与 addWeighted 的 cvRound 一样四舍六入五成双
+            for (int x = 0; x < tile.width; ++x)
+            {
+                int sum = a[x] + b[x], h = sum >> 1;
+                o[x] = static_cast<uchar>(h + (sum & h & 1));
+            }
+        } });
 
     cv::imwrite("aligned_image.png", aligned_display);
     cv::imwrite("overlay.png", overlay);
@@ -4,24 +4,14 @@
 #include <filesystem>
 #include <vector>
 
+#include "../../common/point_ops.hpp"
+
 namespace fs = std::filesystem;
 
+// pow 与 round 只对 256 个灰度各算一次，图像上只做一遍查表
 cv::Mat PowerLawTrans(const cv::Mat &src, double gamma)
 {
-    cv::Mat dst = cv::Mat::zeros(src.size(), src.type());
-    for (int y = 0; y < src.rows; ++y)
-    {
-        const uint8_t *src_row = src.ptr<uint8_t>(y);
-        uint8_t *dst_row = dst.ptr<uint8_t>(y);
-        for (int x = 0; x < src.cols; ++x)
-        {
-            double normalized = static_cast<double>(src_row[x]) / 255.0;
-            double powered = std::pow(normalized, gamma);
-            int scaled = std::round(powered * 255.0);
-            dst_row[x] = static_cast<uint8_t>(std::clamp(scaled, 0, 255));
-        }
-    }
-    return dst;
+    return PointOpChain().gamma(gamma).apply(src);
 }
 
 int main(int argc, char **argv)
@@ -2,13 +2,17 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <numeric>
 #include <cstdint>
 
+#include "../../common/clahe.hpp"
+#include "../../common/histogram.hpp"
+#include "../../common/histogram16.hpp"
+#include "../../common/point_ops.hpp"
+
 using namespace cv;
 
 // 绘制灰度直方图
-static cv::Mat draw_histogram(const std::vector<int> &hist, cv::Size size = {256, 200})
+static cv::Mat draw_histogram(const Histogram256 &hist, cv::Size size = {256, 200})
 {
     int hist_w = size.width, hist_h = size.height;
     int max_val = *std::max_element(hist.begin(), hist.end());
@@ -29,33 +33,67 @@ int main(int argc, char **argv)
 {
     if (argc < 2)
     {
-        std::cerr << "Usage: " << argv[0] << " <input_image>\n";
+        std::cerr << "Usage: " << argv[0] << " <input_image> [global|clahe|sliding] [clip_limit]\n";
         return -1;
     }
 
     std::string input_image_path = argv[1];
-    cv::Mat img = cv::imread(input_image_path, cv::IMREAD_GRAYSCALE);
+    // global：全局均衡化；clahe：8x8 分块 CLAHE；sliding：以每个像素为中心的 65x65 窗口的精确 CLAHE
+    std::string mode = argc >= 3 ? argv[2] : "global";
+    double clip_limit = argc >= 4 ? std::stod(argv[3]) : 2.0;
+    if (mode != "global" && mode != "clahe" && mode != "sliding")
+    {
+        std::cerr << "Error: unknown mode " << mode << "\n";
+        return -1;
+    }
+    // IMREAD_ANYDEPTH：16 位 PNG/TIFF（X 光、CT 等 12~16 位数据）保持原位深
+    cv::Mat img = cv::imread(input_image_path, cv::IMREAD_GRAYSCALE | cv::IMREAD_ANYDEPTH);
     if (img.empty())
     {
         std::cerr << "Error: Cannot open or find the image.\n";
         return -1;
     }
 
-    // Step 1. 计算原图直方图
-    std::vector<int> hist(256, 0);
-    for (int y = 0; y < img.rows; ++y)
+    if (img.depth() == CV_16U)
     {
-        const uint8_t *row_ptr = img.ptr<uint8_t>(y);
-        for (int x = 0; x < img.cols; ++x)
-            ++hist[row_ptr[x]];
+        if (mode != "global")
+        {
+            std::cerr << "Error: 16 位图像只支持 global 模式\n";
+            return -1;
+        }
+        // 两级直方图 + 两级查找表，结果保持 16 位
+        cv::Mat equalized16 = myEqualize16(img);
+        cv::imwrite("./eq16_" + input_image_path + ".png", equalized16);
+
+        // 可视化：原图按实际最大值拉伸到 8 位，均衡化结果按 65535 -> 255 缩放
+        const Histogram16Prefix p16 = myHistogram16Prefix(myHistogram16(img));
+        cv::Mat show, show_eq;
+        img.convertTo(show, CV_8U, 255.0 / std::max<int>(1, p16.value.back()));
+        equalized16.convertTo(show_eq, CV_8U, 1.0 / 257);
+        cv::Mat hist_img = draw_histogram(myHistogram256(show));
+        cv::Mat hist_eq_img = draw_histogram(myHistogram256(show_eq));
+        cv::resize(hist_img, hist_img, img.size());
+        cv::resize(hist_eq_img, hist_eq_img, img.size());
+        cv::cvtColor(hist_img, hist_img, cv::COLOR_BGR2GRAY);
+        cv::cvtColor(hist_eq_img, hist_eq_img, cv::COLOR_BGR2GRAY);
+
+        cv::Mat top, bottom, final;
+        cv::hconcat(show, hist_img, top);
+        cv::hconcat(show_eq, hist_eq_img, bottom);
+        cv::vconcat(top, bottom, final);
+        cv::imwrite("./eq16_visual_" + input_image_path + ".png", final);
+        return 0;
     }
 
-    // Step 2. 计算CDF
-    std::vector<int> cdf(256);
-    std::partial_sum(hist.begin(), hist.end(), cdf.begin());
+    // Step 1. 计算原图直方图（多线程 + 交错子直方图）
+    Histogram256 hist = myHistogram256(img);
+
+    // Step 2. 计算CDF（整数前缀和）
+    HistogramPrefix prefix = myHistogramPrefix(hist);
+    const auto &cdf = prefix.W;
 
     // Step 3. 归一化CDF
-    int total_pixels = img.rows * img.cols;
+    int64_t total_pixels = prefix.total();
 
     std::vector<uint8_t> lut(256);
     for (int i = 0; i < 256; ++i)
@@ -65,23 +103,20 @@ int main(int argc, char **argv)
         lut[i] = static_cast<uint8_t>(equalized_val);
     }
 
-    // Step 4. 应用LUT生成均衡化图像
-    cv::Mat equalized(img.size(), img.type());
-    for (int y = 0; y < img.rows; ++y)
+    // Step 4. 应用LUT生成均衡化图像；CLAHE 模式下每个局部区域用自己的截断 CDF
+    cv::Mat equalized;
+    Histogram256 hist_eq;
+    if (mode == "global")
     {
-        const uint8_t *src_row = img.ptr<uint8_t>(y);
-        uint8_t *dst_row = equalized.ptr<uint8_t>(y);
-        for (int x = 0; x < img.cols; ++x)
-            dst_row[x] = lut[src_row[x]];
+        equalized = myApplyLut(img, lut.data());
+        // Step 5. 计算均衡化后的直方图：由原直方图经 LUT 推出，不再扫描图像
+        hist_eq = myHistogramOfLut(hist, lut.data());
     }
-
-    // Step 5. 计算均衡化后的直方图
-    std::vector<int> hist_eq(256, 0);
-    for (int y = 0; y < equalized.rows; ++y)
+    else
     {
-        const uint8_t *row_ptr = equalized.ptr<uint8_t>(y);
-        for (int x = 0; x < equalized.cols; ++x)
-            ++hist_eq[row_ptr[x]];
+        equalized = mode == "clahe" ? myClahe(img, clip_limit, cv::Size(8, 8)) : myClaheSliding(img, clip_limit, 32);
+        // Step 5. 局部映射不是单张 LUT，只能重新统计
+        hist_eq = myHistogram256(equalized);
     }
 
     // Step 6. 绘制直方图并缩放到图像大小
@@ -100,7 +135,8 @@ int main(int argc, char **argv)
     cv::vconcat(top, bottom, final);
 
     // Step 7. 保存
-    cv::imwrite("./eq_visual_" + input_image_path + ".png", final);
+    const std::string prefix_name = mode == "global" ? "./eq_visual_" : "./" + mode + "_visual_";
+    cv::imwrite(prefix_name + input_image_path + ".png", final);
 
     return 0;
 }
@@ -3,42 +3,14 @@
 #include <vector>
 #include <functional>
 
-cv::Mat conv2D_matrix(const cv::Mat &image, const cv::Mat &kernel)
-{
-
-    int kSize = kernel.rows;
-    int pad = kSize / 2;
-
-    // 镜像填充
-    cv::Mat src;
-    cv::copyMakeBorder(image, src, pad, pad, pad, pad, cv::BORDER_REFLECT);
-
-    cv::Mat dst(image.size(), CV_8U);
-
-    for (int y = 0; y < image.rows; ++y)
-    {
-        for (int x = 0; x < image.cols; ++x)
-        {
-            cv::Rect roi(x, y, kSize, kSize);
-            cv::Mat patch = src(roi);
+#include "../../common/box_filter.hpp"
+#include "../../common/conv.hpp"
 
-            // 转为 double 类型进行乘法
-            cv::Mat patch64;
-            patch.convertTo(patch64, CV_64F);
-
-            double val = cv::sum(patch64.mul(kernel))[0];
-            dst.at<uchar>(y, x) = cv::saturate_cast<uchar>(val);
-        }
-    }
-
-    return dst;
-}
-
-cv::Mat makeBoxKernel(int kSize)
+// 镜像边界（BORDER_REFLECT）的二维卷积：按每像素代价在三条路径中选择——直接卷积、
+// 按 SVD 求出核的秩后的一维分离卷积（秩 1 / 低秩核）、大核时的分块 FFT 卷积
+cv::Mat conv2D_matrix(const cv::Mat &image, const cv::Mat &kernel)
 {
-    cv::Mat kernel = cv::Mat::ones(kSize, kSize, CV_64F);
-    kernel /= (kSize * kSize);
-    return kernel;
+    return myConvolve(image, kernel);
 }
 
 cv::Mat makeGaussianKernel(int kSize, double sigma)
@@ -77,8 +49,8 @@ int main(int argc, char **argv)
 
     if (filterType == "box")
     {
-        cv::Mat kernel = makeBoxKernel(kSize);
-        result = conv2D_matrix(image, kernel);
+        // 均值滤波：滑动列和 + 滑动行和，代价与核大小无关
+        result = myBoxFilter(image, cv::Size(kSize, kSize));
     }
     else if (filterType == "gaussian")
     {
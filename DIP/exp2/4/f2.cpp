@@ -1,44 +1,13 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
-std::vector<cv::Mat> secondOrderFilter(const cv::Mat &image_in, bool use8 = false, double k = 1.0)
-{
-    // 转为 double 精度
-    cv::Mat image;
-    image_in.convertTo(image, CV_64F);
 
-    // 定义卷积核
-    cv::Mat kernel;
-    if (use8)
-    {
-        // -8 核
-        kernel = (cv::Mat_<double>(3, 3) << 1, 1, 1,
-                  1, -8, 1,
-                  1, 1, 1);
-    }
-    else
-    {
-        // -4 核
-        kernel = (cv::Mat_<double>(3, 3) << 0, 1, 0,
-                  1, -4, 1,
-                  0, 1, 0);
-    }
+#include "../../common/sharpen.hpp"
 
-    // 卷积运算
-    cv::Mat laplace;
-    cv::filter2D(image, laplace, CV_64F, kernel);
-
-    // 增强结果：image - k * laplace
-    cv::Mat enhanced = image - k * laplace;
-
-    // 限制范围 [0, 255]
-    cv::Mat laplace_clipped, enhanced_clipped;
-    cv::min(cv::max(laplace, 0.0), 255.0, laplace_clipped);
-    cv::min(cv::max(enhanced, 0.0), 255.0, enhanced_clipped);
-
-    // 转回 8-bit
+std::vector<cv::Mat> secondOrderFilter(const cv::Mat &image_in, bool use8 = false, double k = 1.0)
+{
+    // -4 / -8 拉普拉斯核，一遍写出截断后的拉普拉斯图与增强结果 image - k * laplace
     cv::Mat laplace_u8, enhanced_u8;
-    laplace_clipped.convertTo(laplace_u8, CV_8U);
-    enhanced_clipped.convertTo(enhanced_u8, CV_8U);
+    myLaplacianSharpen(image_in, use8, k, laplace_u8, enhanced_u8);
 
     return {image_in, laplace_u8, enhanced_u8};
 }
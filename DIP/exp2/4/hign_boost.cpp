@@ -1,29 +1,24 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
 
+#include "../../common/sharpen.hpp"
+
 // 返回 Vector<cv::Mat>, 包含 平滑图 Mask 和 高提升图
-std::vector<cv::Mat> highBoostFilter(const cv::Mat &image_in, float k = 1.5, int kernelSize = 3, double sigma = 1.0)
+// canvas 非空时（rows x 3cols 的 CV_8UC1），三个结果直接写进它的左、中、右三块，返回的是这三块的视图
+std::vector<cv::Mat> highBoostFilter(const cv::Mat &image_in, float k = 1.5, int kernelSize = 3, double sigma = 1.0, cv::Mat canvas = cv::Mat())
 {
-
-    cv::Mat image;
-    image_in.convertTo(image, CV_64F);
-
-    cv::Mat smooth;
-    // 高斯平滑
-    cv::GaussianBlur(image, smooth, cv::Size(kernelSize, kernelSize), sigma);
-
-    cv::Mat mask = image - smooth;
-    cv::Mat highboost = image + k * mask;
-
-    // 限制范围 [0, 255]
-    cv::min(cv::max(smooth, 0.0), 255.0, smooth);
-    cv::min(cv::max(mask, 0.0), 255.0, mask);
-    cv::min(cv::max(highboost, 0.0), 255.0, highboost);
-
     cv::Mat smooth_u8, mask_u8, highboost_u8;
-    smooth.convertTo(smooth_u8, CV_8U);
-    mask.convertTo(mask_u8, CV_8U);
-    highboost.convertTo(highboost_u8, CV_8U);
+    if (!canvas.empty())
+    {
+        CV_Assert(canvas.type() == CV_8UC1 && canvas.rows == image_in.rows && canvas.cols == 3 * image_in.cols);
+        const int w = image_in.cols;
+        smooth_u8 = canvas.colRange(0, w);
+        mask_u8 = canvas.colRange(w, 2 * w);
+        highboost_u8 = canvas.colRange(2 * w, 3 * w);
+    }
+
+    // 按行带一遍算出平滑、Mask（image - smooth）与高提升（image + k * mask），各自截断到 [0, 255]
+    myHighBoost(image_in, k, kernelSize, sigma, smooth_u8, mask_u8, highboost_u8);
     return {smooth_u8, mask_u8, highboost_u8};
 }
 
@@ -44,10 +39,10 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    std::vector<cv::Mat> result_vec = highBoostFilter(image, 1.5, 11, 5);
-    cv::Mat result;
-    cv::hconcat(result_vec, result);
-    cv::hconcat(image, result, result);
+    // 原图 | 平滑 | Mask | 高提升，结果直接写进拼接画布
+    cv::Mat result(image.rows, 4 * image.cols, CV_8UC1);
+    image.copyTo(result.colRange(0, image.cols));
+    highBoostFilter(image, 1.5, 11, 5, result.colRange(image.cols, 4 * image.cols));
 
     cv::imwrite(imagePath + "_highboost.png", result);
 
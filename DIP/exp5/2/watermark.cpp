@@ -1,5 +1,7 @@
 #include <opencv2/opencv.hpp>
 
+#include "../../common/bit_planes.hpp"
+
 using namespace cv;
 
 void addVisibleWatermark(const Mat &original, const Mat &watermark, Mat &output, double alpha)
@@ -19,15 +21,24 @@ void addInvisibleWatermark(const Mat &original, const Mat &watermark, Mat &outpu
     Rect roi(original.cols - watermark.cols, original.rows - watermark.rows, watermark.cols, watermark.rows);
     watermark.copyTo(padded_watermark(roi));
 
-    Mat low2_bits = (padded_watermark & 0xC0) / 64;
-    Mat high6_bits = original & 0xFC;
-    output = high6_bits | low2_bits;
+    // 原图的低 2 个位平面换成水印的高 2 个位平面（打包平面上整字交换），再合并
+    BitPlanes planes = myBitPlaneSplit(original);
+    BitPlanes marks = myBitPlaneSplit(padded_watermark);
+    planes[0] = std::move(marks[6]);
+    planes[1] = std::move(marks[7]);
+    output = myBitPlaneMerge(planes);
 }
 
 void extractInvisibleWatermark(const Mat &watermarked, Mat &extracted_watermark)
 {
-    Mat low2_bits = watermarked & 0x03;
-    multiply(low2_bits, 64, extracted_watermark, 1, watermarked.type());
+    // 低 2 个位平面放回高 2 位，其余平面为 0
+    BitPlanes planes = myBitPlaneSplit(watermarked);
+    BitPlanes extracted;
+    for (int b = 0; b < 6; ++b)
+        extracted[b] = BitPlane(watermarked.rows, watermarked.cols);
+    extracted[6] = std::move(planes[0]);
+    extracted[7] = std::move(planes[1]);
+    extracted_watermark = myBitPlaneMerge(extracted);
 }
 
 int main()
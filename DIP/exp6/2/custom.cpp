@@ -3,14 +3,15 @@
 #include <vector>
 #include <cmath>
 
+#include "../../common/gaussian.hpp"
+
 int main()
 {
     cv::Mat src = cv::imread("ct_crop.png", cv::IMREAD_GRAYSCALE);
     if (src.empty())
         return -1;
 
-    cv::Mat blurred;
-    cv::GaussianBlur(src, blurred, cv::Size(9, 9), 2, 2);
+    cv::Mat blurred = myGaussianBlur(src, 2, 9);
 
     cv::Mat grad_x, grad_y;
     cv::Sobel(blurred, grad_x, CV_32F, 1, 0);
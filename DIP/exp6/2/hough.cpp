@@ -2,12 +2,14 @@
 #include <iostream>
 #include <vector>
 
+#include "../../common/gaussian.hpp"
+
 int main()
 {
     cv::Mat src = cv::imread("ct_1.png", cv::IMREAD_GRAYSCALE);
 
     // 高斯模糊减少噪声干扰，有助于霍夫变换的准确性
-    cv::GaussianBlur(src, src, cv::Size(9, 9), 2, 2);
+    src = myGaussianBlur(src, 2, 9);
 
     // 参数说明:
     // dp=1: 累加器分辨率与图像分辨率相同
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <vector>
 
+#include "../../common/bit_planes.hpp"
+
 int main(int argc, char *argv[])
 {
     if (argc < 3)
@@ -19,14 +21,26 @@ int main(int argc, char *argv[])
 
     std::string output_prefix = argv[2];
 
-    // Bit-plane slicing for 8-bit grayscale image
+    // Bit-plane slicing for 8-bit grayscale image: one pass into 8 packed 1-bit planes
+    BitPlanes planes = myBitPlaneSplit(image);
     for (int bit = 0; bit < 8; ++bit)
     {
-        cv::Mat bit_plane = (image & (1 << bit)) * 255; // Extract and scale to 0-255
+        cv::Mat bit_plane = myBitPlaneToMat(planes[bit]); // Expand to 0/255 only for saving
         std::string filename = output_prefix + "_bit" + std::to_string(bit) + ".png";
         cv::imwrite(filename, bit_plane);
         std::cout << "Saved: " << filename << std::endl;
     }
 
+    // Reconstruct from the highest 4, 3 and 2 planes: clear the low planes in packed form and merge
+    for (int keep = 4; keep >= 2; --keep)
+    {
+        for (int bit = 0; bit < 8 - keep; ++bit)
+            std::fill(planes[bit].data.begin(), planes[bit].data.end(), 0);
+        cv::Mat rebuilt = myBitPlaneMerge(planes);
+        std::string filename = output_prefix + "_top" + std::to_string(keep) + ".png";
+        cv::imwrite(filename, rebuilt);
+        std::cout << "Saved: " << filename << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
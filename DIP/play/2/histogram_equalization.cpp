@@ -2,39 +2,60 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <numeric>
 #include <cstdint>
 
-int main()
+#include "../../common/clahe.hpp"
+#include "../../common/histogram.hpp"
+#include "../../common/histogram16.hpp"
+#include "../../common/point_ops.hpp"
+
+int main(int argc, char **argv)
 {
+    // 可选模式：global（默认，全局均衡化）、clahe（8x8 分块 CLAHE）、sliding（65x65 滑动窗口 CLAHE）
+    std::string mode = argc >= 2 ? argv[1] : "global";
+    double clip_limit = argc >= 3 ? std::stod(argv[2]) : 2.0;
+    // 可选输入路径；16 位 PNG/TIFF 保持原位深
+    std::string input = argc >= 4 ? argv[3] : "input.jpg";
+
     // 加载灰度图像
-    cv::Mat img = cv::imread("input.jpg", cv::IMREAD_GRAYSCALE);
+    cv::Mat img = cv::imread(input, cv::IMREAD_GRAYSCALE | cv::IMREAD_ANYDEPTH);
     if (img.empty())
     {
         std::cerr << "Error: Cannot open or find the image.\n";
         return -1;
     }
 
-    // Step 1. 计算灰度直方图（0~255）
-    std::vector<int> hist(256, 0);
-    for (int y = 0; y < img.rows; ++y)
+    if (img.depth() == CV_16U)
     {
-        const uint8_t *row_ptr = img.ptr<uint8_t>(y);
-        for (int x = 0; x < img.cols; ++x)
+        if (mode != "global")
         {
-            ++hist[row_ptr[x]];
+            std::cerr << "Error: 16 位图像只支持 global 模式\n";
+            return -1;
         }
+        // 16 位结果不能存成 JPEG
+        cv::imwrite("output.png", myEqualize16(img));
+        return 0;
+    }
+
+    if (mode == "clahe" || mode == "sliding")
+    {
+        cv::Mat local = mode == "clahe" ? myClahe(img, clip_limit, cv::Size(8, 8)) : myClaheSliding(img, clip_limit, 32);
+        cv::imwrite("output.jpg", local);
+        return 0;
     }
 
+    // Step 1. 计算灰度直方图（0~255）
+    Histogram256 hist = myHistogram256(img);
+
     // Step 2. 计算累计分布函数（CDF）
-    std::vector<int> cdf(256);
-    std::partial_sum(hist.begin(), hist.end(), cdf.begin());
+    HistogramPrefix prefix = myHistogramPrefix(hist);
+    const auto &cdf = prefix.W;
 
     // Step 3. 归一化 CDF 到 [0, 255]
-    int total_pixels = img.rows * img.cols;
+    int64_t total_pixels = prefix.total();
 
     // 找到第一个非零的 CDF（避免暗图出现拉伸错误）
-    int cdf_min = 0;
+    int64_t cdf_min = 0;
     for (int i = 0; i < 256; ++i)
     {
         if (cdf[i] != 0)
@@ -53,16 +74,7 @@ int main()
     }
 
     // Step 4. 应用查找表（LUT）生成均衡化结果
-    cv::Mat equalized(img.size(), img.type());
-    for (int y = 0; y < img.rows; ++y)
-    {
-        const uint8_t *src_row = img.ptr<uint8_t>(y);
-        uint8_t *dst_row = equalized.ptr<uint8_t>(y);
-        for (int x = 0; x < img.cols; ++x)
-        {
-            dst_row[x] = lut[src_row[x]];
-        }
-    }
+    cv::Mat equalized = myApplyLut(img, lut.data());
 
     // Step 5. 保存结果
     cv::imwrite("output.jpg", equalized);
@@ -3,27 +3,39 @@
 //
 // 编译： g++ -std=c++20 radon.cpp `pkg-config --cflags --libs opencv4` -O2 -o radon
 //
-// 用法： ./radon input.png sinogram.png profile.png [num_angles] [profile_angle_deg]
+// 用法： ./radon input.png sinogram.png profile.png [num_angles] [profile_angle_deg] [plan|shear]
 //   默认 num_angles = 180 (0..179 deg)
 //   默认 profile_angle_deg = 90
+//   旋转方式默认 plan（缓存的双线性重映射表）；shear 使用三次剪切旋转，不需要建表
 //
 // 输出：生成 sinogram（灰度图）和指定角度的剖面图（profile）
 
 #include <opencv2/opencv.hpp>
 #include <cmath>
 #include <iostream>
+#include <optional>
 #include <string>
 
+#include "../../common/shear_rotate.hpp"
+#include "../../common/warp_plan.hpp"
+
 using namespace cv;
 using std::cerr;
 using std::cout;
 using std::endl;
 using std::string;
 
-static Mat rotateImage(const Mat &src, double angle_deg, const Size &dstSize)
+// planCache 为空时用三次剪切旋转
+static Mat rotateImage(const Mat &src, double angle_deg, const Size &dstSize, WarpPlanCache *planCache)
 {
     // 旋转中心取图像中心；使用双线性插值并填充为 0（黑）
     Point2f center((float)(src.cols / 2.0), (float)(src.rows / 2.0));
+
+    // 三次剪切：同样把 src 的中心平移到 dst 的中心
+    if (!planCache)
+        return myRotateThreeShear(src, angle_deg, center, dstSize,
+                                  Point2d((dstSize.width - src.cols) / 2.0, (dstSize.height - src.rows) / 2.0));
+
     Mat M = getRotationMatrix2D(center, angle_deg, 1.0);
 
     // 为了把旋转后的图像完整装下，先把仿射矩阵平移到目标图像中心
@@ -33,7 +45,7 @@ static Mat rotateImage(const Mat &src, double angle_deg, const Size &dstSize)
     M.at<double>(1, 2) += (dstSize.height - src.rows) / 2.0;
 
     Mat dst;
-    warpAffine(src, dst, M, dstSize, INTER_LINEAR, BORDER_CONSTANT, Scalar(0));
+    planCache->get(src.size(), M, dstSize, INTER_LINEAR).apply(src, dst);
     return dst;
 }
 
@@ -41,13 +53,14 @@ int main(int argc, char **argv)
 {
     if (argc < 2)
     {
-        cout << "Usage: " << argv[0] << " input.png [num_angles] [profile_angle_deg]\n";
+        cout << "Usage: " << argv[0] << " input.png [num_angles] [profile_angle_deg] [plan|shear]\n";
         return 0;
     }
 
     string inPath = argv[1];
     int numAngles = (argc >= 3) ? std::stoi(argv[2]) : 180;
     int profileAngleDeg = (argc >= 4) ? std::stoi(argv[3]) : 90;
+    bool useShear = (argc >= 5) && string(argv[4]) == "shear";
     string sinogramOut = "sinogram" + std::to_string(numAngles) + ".png";
     string profileOut = "profile" + std::to_string(profileAngleDeg) + ".png";
 
@@ -74,6 +87,12 @@ int main(int argc, char **argv)
     int yoff = (padSize.height - img_d.rows) / 2;
     img_d.copyTo(padded(Rect(xoff, yoff, img_d.cols, img_d.rows)));
 
+    // 每次运行 180 个角度的重映射表完全相同：缓存到磁盘供后续运行直接加载。
+    // 一次运行内每个角度只用一次，内存中只保留当前这张表（每张约 outSize^2 * 6 字节）
+    std::optional<WarpPlanCache> planCache;
+    if (!useShear)
+        planCache.emplace("./radon_plans", 1);
+
     // sinogram: 每一行对应一个角度，每列对应投影位置 s
     Mat sinogram = Mat::zeros(numAngles, outSize, CV_64F);
 
@@ -82,7 +101,7 @@ int main(int argc, char **argv)
     {
         double theta = (180.0 * i) / numAngles; // degrees
         // 为了得到角度 theta 的投影，我们把图像逆向旋转 -theta（使该投影变为竖直方向上的列和）
-        Mat rotated = rotateImage(padded, -theta, padSize);
+        Mat rotated = rotateImage(padded, -theta, padSize, planCache ? &*planCache : nullptr);
 
         // 对列方向求和 => 得到长度为 outSize 的投影向量
         Mat projection;